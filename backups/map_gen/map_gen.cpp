@@ -1,10 +1,34 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <string>
 #include <vector>
 #include <random>
 #include <ctime>
 #include <algorithm>
+#include <tuple>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <filesystem>
+#include <unordered_map>
+#include <charconv>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // Struttura per restituire sia le mosse che il percorso completo
 struct PathResult {
@@ -18,6 +42,22 @@ struct DijkstraResult {
     std::vector<std::vector<std::vector<std::tuple<int, int, int>>>> parent;
 };
 
+// Statistiche sul grafo degli stati (cella, direzione) raggiungibili da I
+struct SlideGraphStats {
+    int reachable_states;   // Stati raggiungibili dall'ingresso
+    int trap_states;        // Stati raggiungibili da cui E non è più raggiungibile
+    double trap_ratio;      // trap_states / reachable_states
+    double mean_branching;  // Numero medio di mosse valide per stato (E escluso)
+    int largest_cycle;      // Stati nella componente fortemente connessa più grande (0 = nessun ciclo)
+};
+
+// Filtri di accettazione opzionali per generateMap (i valori di default non scartano nulla)
+struct AcceptanceFilters {
+    double max_trap_ratio = 1.0;    // Percentuale massima di stati trappola
+    double min_branching = 0.0;     // Fattore di ramificazione medio minimo
+    int max_cycle = -1;             // Dimensione massima del ciclo più grande (-1 = nessun limite)
+};
+
 // Funzioni utility
 std::string directionToString(int dir) {
     switch (dir) {
@@ -33,47 +73,80 @@ bool isValidPosition(int x, int y, int width, int height) {
     return x >= 0 && x < width && y >= 0 && y < height;
 }
 
-bool isWall(const std::vector<std::vector<char>>& map, int x, int y) {
-    return map[y][x] == 'M';
-}
+// Caratteristiche di terreno presenti in una mappa: il solver viene specializzato su questa maschera.
+// Il ghiaccio fragile 'D' non ha un bit: per il solver è identico a 'G' (stessa classe TILE_SLIDE).
+enum MapFeature : unsigned {
+    FEATURE_NONE = 0,
+    FEATURE_HOLES = 1u << 0,        // 'B' e 'X' (dalla difficoltà 3)
+    FEATURE_CONVEYORS = 1u << 1,    // '1'-'4' (dalla difficoltà 4)
+    FEATURE_ALL = FEATURE_HOLES | FEATURE_CONVEYORS
+};
 
-bool isIce(const std::vector<std::vector<char>>& map, int x, int y) {
-    return map[y][x] == 'G';
-}
+// Classi di terreno della tabella di lookup (la direzione del nastro è nei bit alti)
+constexpr uint8_t TILE_WALL = 1u << 0;        // M
+constexpr uint8_t TILE_SLIDE = 1u << 1;       // G e D: si continua a scivolare
+constexpr uint8_t TILE_STOP = 1u << 2;        // T, I, E: ci si ferma
+constexpr uint8_t TILE_DEADLY = 1u << 3;      // B e X (ghiaccio fragile rotto)
+constexpr uint8_t TILE_CONVEYOR = 1u << 4;    // 1-4
+constexpr int TILE_CONVEYOR_SHIFT = 6;
 
-bool isStoppingTerrain(const std::vector<std::vector<char>>& map, int x, int y) {
-    return map[y][x] == 'T' || map[y][x] == 'I' || map[y][x] == 'E';
-}
+// Direzioni: destra, sinistra, giù, su (stesso ordine dei nastri '1'-'4')
+constexpr int DIR_DX[] = {1, -1, 0, 0};
+constexpr int DIR_DY[] = {0, 0, 1, -1};
 
-// Nuova funzione per verificare se una posizione è un nastro trasportatore
-bool isConveyorBelt(const std::vector<std::vector<char>>& map, int x, int y) {
-    char cell = map[y][x];
-    return cell == '1' || cell == '2' || cell == '3' || cell == '4';
+constexpr std::array<uint8_t, 256> buildTileTable() {
+    std::array<uint8_t, 256> table = {};
+    table['M'] = TILE_WALL;
+    table['G'] = TILE_SLIDE;
+    table['D'] = TILE_SLIDE;
+    table['T'] = TILE_STOP;
+    table['I'] = TILE_STOP;
+    table['E'] = TILE_STOP;
+    table['B'] = TILE_DEADLY;
+    table['X'] = TILE_DEADLY;
+    for (int dir = 0; dir < 4; dir++) {
+        table['1' + dir] = static_cast<uint8_t>(TILE_CONVEYOR | (dir << TILE_CONVEYOR_SHIFT));
+    }
+    return table;
 }
 
-// Funzione per ottenere la direzione del nastro trasportatore
-int getConveyorDirection(const std::vector<std::vector<char>>& map, int x, int y) {
-    char cell = map[y][x];
-    switch (cell) {
-        case '1': return 0; // DESTRA
-        case '2': return 1; // SINISTRA
-        case '3': return 2; // GIU
-        case '4': return 3; // SU
-        default: return -1;
-    }
+constexpr std::array<uint8_t, 256> TILE_TABLE = buildTileTable();
+
+inline uint8_t tileClass(char cell) {
+    return TILE_TABLE[static_cast<unsigned char>(cell)];
 }
 
-// Nuova funzione per verificare se una posizione è ghiaccio fragile
-bool isFragileIce(const std::vector<std::vector<char>>& map, int x, int y) {
-    return map[y][x] == 'D';
+bool isWall(const std::vector<std::vector<char>>& map, int x, int y) {
+    return tileClass(map[y][x]) & TILE_WALL;
 }
 
 // Funzione aggiornata per verificare se una posizione è mortale (include ghiaccio rotto)
 bool isDeadlyTerrain(const std::vector<std::vector<char>>& map, int x, int y) {
-    return map[y][x] == 'B' || map[y][x] == 'X'; // X = ghiaccio fragile rotto
+    return tileClass(map[y][x]) & TILE_DEADLY;
+}
+
+// Versione specializzata: senza buchi nella mappa il controllo sparisce a compile-time
+template <unsigned Features>
+inline bool isDeadlyTerrainFor(const std::vector<std::vector<char>>& map, int x, int y) {
+    if constexpr ((Features & FEATURE_HOLES) != 0) {
+        return isDeadlyTerrain(map, x, y);
+    } else {
+        return false;
+    }
+}
+
+// Maschera delle caratteristiche generate per ogni difficoltà (vedi le funzioni add*)
+unsigned featuresForDifficulty(int difficulty) {
+    unsigned features = FEATURE_NONE;
+    if (difficulty >= 3) features |= FEATURE_HOLES;
+    if (difficulty >= 4) features |= FEATURE_CONVEYORS;
+    return features;
 }
 
 // Funzione per simulare il movimento con scivolamento (aggiornata per nastri trasportatori)
+// Specializzata sulle caratteristiche della mappa: i rami per terreni assenti non vengono compilati.
+// G e D appartengono alla stessa classe, quindi il ghiaccio fragile non costa nessun controllo extra.
+template <unsigned Features = FEATURE_ALL>
 std::pair<int, int> simulateMove(const std::vector<std::vector<char>>& map, int x, int y, int dx, int dy) {
     int width = static_cast<int>(map[0].size());
     int height = static_cast<int>(map.size());
@@ -86,14 +159,18 @@ std::pair<int, int> simulateMove(const std::vector<std::vector<char>>& map, int
         return {x, y}; // Non si muove
     }
     
+    uint8_t tile = tileClass(map[new_y][new_x]);
+    
     // Se colpisce un muro, non si muove
-    if (isWall(map, new_x, new_y)) {
+    if (tile & TILE_WALL) {
         return {x, y};
     }
     
     // Se finisce su un buco o ghiaccio rotto, game over
-    if (isDeadlyTerrain(map, new_x, new_y)) {
-        return {new_x, new_y}; // Finisce nel buco/ghiaccio rotto = morte
+    if constexpr ((Features & FEATURE_HOLES) != 0) {
+        if (tile & TILE_DEADLY) {
+            return {new_x, new_y}; // Finisce nel buco/ghiaccio rotto = morte
+        }
     }
     
     // Variabili per la direzione attuale di movimento
@@ -101,27 +178,30 @@ std::pair<int, int> simulateMove(const std::vector<std::vector<char>>& map, int
     int current_dy = dy;
     
     // Se finisce su un nastro trasportatore, viene spinto e cambia direzione
-    if (isConveyorBelt(map, new_x, new_y)) {
-        int conveyor_dir = getConveyorDirection(map, new_x, new_y);
-        int conv_dx[] = {1, -1, 0, 0}; // destra, sinistra, giù, su
-        int conv_dy[] = {0, 0, 1, -1};
-        
-        // Spinto di una cella nella direzione del nastro
-        int pushed_x = new_x + conv_dx[conveyor_dir];
-        int pushed_y = new_y + conv_dy[conveyor_dir];
-        
-        // Controlla se la posizione spinta è valida
-        if (isValidPosition(pushed_x, pushed_y, width, height) && !isWall(map, pushed_x, pushed_y)) {
-            new_x = pushed_x;
-            new_y = pushed_y;
+    if constexpr ((Features & FEATURE_CONVEYORS) != 0) {
+        if (tile & TILE_CONVEYOR) {
+            int conveyor_dir = tile >> TILE_CONVEYOR_SHIFT;
             
-            // IMPORTANTE: Cambia la direzione di movimento a quella del nastro
-            current_dx = conv_dx[conveyor_dir];
-            current_dy = conv_dy[conveyor_dir];
+            // Spinto di una cella nella direzione del nastro
+            int pushed_x = new_x + DIR_DX[conveyor_dir];
+            int pushed_y = new_y + DIR_DY[conveyor_dir];
             
-            // Se finisce su un buco dopo essere stato spinto, game over
-            if (isDeadlyTerrain(map, new_x, new_y)) {
-                return {new_x, new_y};
+            // Controlla se la posizione spinta è valida
+            if (isValidPosition(pushed_x, pushed_y, width, height) && !isWall(map, pushed_x, pushed_y)) {
+                new_x = pushed_x;
+                new_y = pushed_y;
+                tile = tileClass(map[new_y][new_x]);
+                
+                // IMPORTANTE: Cambia la direzione di movimento a quella del nastro
+                current_dx = DIR_DX[conveyor_dir];
+                current_dy = DIR_DY[conveyor_dir];
+                
+                // Se finisce su un buco dopo essere stato spinto, game over
+                if constexpr ((Features & FEATURE_HOLES) != 0) {
+                    if (tile & TILE_DEADLY) {
+                        return {new_x, new_y};
+                    }
+                }
             }
         }
     }
@@ -131,7 +211,7 @@ std::pair<int, int> simulateMove(const std::vector<std::vector<char>>& map, int
     const int MAX_ITERATIONS = std::max(width, height); // Limite basato sulla dimensione della mappa
     
     // Se finisce su ghiaccio normale o fragile, continua a scivolare
-    while ((isIce(map, new_x, new_y) || isFragileIce(map, new_x, new_y)) && iterations < MAX_ITERATIONS) {
+    while ((tile & TILE_SLIDE) && iterations < MAX_ITERATIONS) {
         iterations++;
         
         // USA LA DIREZIONE ATTUALE (che può essere cambiata dal nastro)
@@ -143,58 +223,66 @@ std::pair<int, int> simulateMove(const std::vector<std::vector<char>>& map, int
             break;
         }
         
+        uint8_t next_tile = tileClass(map[next_y][next_x]);
+        
         // Se il prossimo è un muro, si ferma sulla posizione attuale
-        if (isWall(map, next_x, next_y)) {
+        if (next_tile & TILE_WALL) {
             break;
         }
         
         new_x = next_x;
         new_y = next_y;
+        tile = next_tile;
         
         // Se finisce su un buco o ghiaccio rotto durante lo scivolamento, game over
-        if (isDeadlyTerrain(map, new_x, new_y)) {
-            return {new_x, new_y}; // Morte durante lo scivolamento
+        if constexpr ((Features & FEATURE_HOLES) != 0) {
+            if (tile & TILE_DEADLY) {
+                return {new_x, new_y}; // Morte durante lo scivolamento
+            }
         }
         
         // Se finisce su terreno normale o I/E, si ferma
-        if (isStoppingTerrain(map, new_x, new_y)) {
+        if (tile & TILE_STOP) {
             break;
         }
         
         // Se finisce su un nastro trasportatore durante lo scivolamento
-        if (isConveyorBelt(map, new_x, new_y)) {
-            int conveyor_dir = getConveyorDirection(map, new_x, new_y);
-            int conv_dx[] = {1, -1, 0, 0};
-            int conv_dy[] = {0, 0, 1, -1};
-            
-            // Spinto di una cella nella direzione del nastro
-            int pushed_x = new_x + conv_dx[conveyor_dir];
-            int pushed_y = new_y + conv_dy[conveyor_dir];
-            
-            // Controlla se può essere spinto
-            if (isValidPosition(pushed_x, pushed_y, width, height) && !isWall(map, pushed_x, pushed_y)) {
-                new_x = pushed_x;
-                new_y = pushed_y;
-                
-                // IMPORTANTE: Cambia nuovamente la direzione di movimento
-                current_dx = conv_dx[conveyor_dir];
-                current_dy = conv_dy[conveyor_dir];
+        if constexpr ((Features & FEATURE_CONVEYORS) != 0) {
+            if (tile & TILE_CONVEYOR) {
+                int conveyor_dir = tile >> TILE_CONVEYOR_SHIFT;
                 
-                // Se finisce su un buco dopo essere stato spinto, game over
-                if (isDeadlyTerrain(map, new_x, new_y)) {
-                    return {new_x, new_y};
-                }
+                // Spinto di una cella nella direzione del nastro
+                int pushed_x = new_x + DIR_DX[conveyor_dir];
+                int pushed_y = new_y + DIR_DY[conveyor_dir];
                 
-                // Se finisce su terreno che ferma dopo essere stato spinto, si ferma
-                if (isStoppingTerrain(map, new_x, new_y)) {
+                // Controlla se può essere spinto
+                if (isValidPosition(pushed_x, pushed_y, width, height) && !isWall(map, pushed_x, pushed_y)) {
+                    new_x = pushed_x;
+                    new_y = pushed_y;
+                    tile = tileClass(map[new_y][new_x]);
+                    
+                    // IMPORTANTE: Cambia nuovamente la direzione di movimento
+                    current_dx = DIR_DX[conveyor_dir];
+                    current_dy = DIR_DY[conveyor_dir];
+                    
+                    // Se finisce su un buco dopo essere stato spinto, game over
+                    if constexpr ((Features & FEATURE_HOLES) != 0) {
+                        if (tile & TILE_DEADLY) {
+                            return {new_x, new_y};
+                        }
+                    }
+                    
+                    // Se finisce su terreno che ferma dopo essere stato spinto, si ferma
+                    if (tile & TILE_STOP) {
+                        break;
+                    }
+                    
+                    // Continua a scivolare nella NUOVA direzione
+                    // (il while continuerà l'iterazione con current_dx e current_dy aggiornati)
+                } else {
+                    // Non può essere spinto, si ferma sul nastro
                     break;
                 }
-                
-                // Continua a scivolare nella NUOVA direzione
-                // (il while continuerà l'iterazione con current_dx e current_dy aggiornati)
-            } else {
-                // Non può essere spinto, si ferma sul nastro
-                break;
             }
         }
     }
@@ -202,100 +290,143 @@ std::pair<int, int> simulateMove(const std::vector<std::vector<char>>& map, int
     return {new_x, new_y};
 }
 
-// Funzione per verificare se esiste un percorso da I a E (corretta per nastri trasportatori)
-bool hasValidPath(const std::vector<std::vector<char>>& map, int start_x, int start_y, int end_x, int end_y) {
-    int width = static_cast<int>(map[0].size());
-    int height = static_cast<int>(map.size());
+// Ricerca in ampiezza riprendibile: verifica se esiste un percorso da I a E (corretta per nastri trasportatori)
+// Il lavoro viene diviso in fette limitate, così un host single-thread può distribuirlo su più frame
+template <unsigned Features = FEATURE_ALL>
+struct PathSearch {
+    const std::vector<std::vector<char>>* map = nullptr;
+    int end_x = 0;
+    int end_y = 0;
     
     // Usa un set per tracciare stati visitati: (x, y, direzione_arrivo)
     // Questo previene loop infiniti con i nastri trasportatori
-    std::vector<std::vector<std::vector<bool>>> visited(height, 
-        std::vector<std::vector<bool>>(width, std::vector<bool>(5, false)));
-    
-    // Usa deque invece di vector per una queue efficiente
+    std::vector<std::vector<std::vector<bool>>> visited;
     std::vector<std::tuple<int, int, int>> queue; // x, y, direzione_arrivo
-    int queue_front = 0; // Indice del front della queue
+    size_t queue_front = 0; // Indice del front della queue
+    bool found = false;
     
-    queue.push_back({start_x, start_y, 4}); // 4 = stato iniziale
-    visited[start_y][start_x][4] = true;
+    void reset(const std::vector<std::vector<char>>& search_map, int start_x, int start_y, int target_x, int target_y) {
+        int width = static_cast<int>(search_map[0].size());
+        int height = static_cast<int>(search_map.size());
+        
+        map = &search_map;
+        end_x = target_x;
+        end_y = target_y;
+        visited.assign(height, std::vector<std::vector<bool>>(width, std::vector<bool>(5, false)));
+        queue.clear();
+        queue_front = 0;
+        found = false;
+        
+        queue.push_back({start_x, start_y, 4}); // 4 = stato iniziale
+        visited[start_y][start_x][4] = true;
+    }
     
-    // Direzioni: destra, sinistra, giù, su
-    int dx[] = {1, -1, 0, 0};
-    int dy[] = {0, 0, 1, -1};
+    bool finished() const {
+        return found || queue_front >= queue.size();
+    }
     
-    int iterations = 0;
-
-    while (queue_front < static_cast<int>(queue.size()) ) {
-        iterations++;
-        auto [x, y, last_dir] = queue[queue_front];
-        queue_front++; // Simula pop_front senza cancellare
-        if (x == end_x && y == end_y) {
-            return true;
-        }
-        
-        // Prova tutte le direzioni
-        for (int i = 0; i < 4; i++) {
-            auto [new_x, new_y] = simulateMove(map, x, y, dx[i], dy[i]);
-            // Se non si muove o finisce in un buco, questa mossa non è valida
-            if ((new_x == x && new_y == y) || isDeadlyTerrain(map, new_x, new_y)) {
-                continue;
+    // Espande al massimo max_expansions stati; restituisce true quando la ricerca è terminata
+    bool advance(int max_expansions) {
+        for (int expanded = 0; expanded < max_expansions && !finished(); expanded++) {
+            auto [x, y, last_dir] = queue[queue_front];
+            queue_front++; // Simula pop_front senza cancellare
+            if (x == end_x && y == end_y) {
+                found = true;
+                break;
             }
             
-            // Controlla se questo stato è già stato visitato
-            if (!visited[new_y][new_x][i]) {
-                visited[new_y][new_x][i] = true;
-                queue.push_back({new_x, new_y, i});
+            // Prova tutte le direzioni
+            for (int i = 0; i < 4; i++) {
+                auto [new_x, new_y] = simulateMove<Features>(*map, x, y, DIR_DX[i], DIR_DY[i]);
+                // Se non si muove o finisce in un buco, questa mossa non è valida
+                if ((new_x == x && new_y == y) || isDeadlyTerrainFor<Features>(*map, new_x, new_y)) {
+                    continue;
+                }
+                
+                // Controlla se questo stato è già stato visitato
+                if (!visited[new_y][new_x][i]) {
+                    visited[new_y][new_x][i] = true;
+                    queue.push_back({new_x, new_y, i});
+                }
             }
         }
+        return finished();
     }
-    
-    return false;
+};
+
+// Funzione per verificare se esiste un percorso da I a E in un'unica chiamata
+template <unsigned Features = FEATURE_ALL>
+bool hasValidPath(const std::vector<std::vector<char>>& map, int start_x, int start_y, int end_x, int end_y) {
+    PathSearch<Features> search;
+    search.reset(map, start_x, start_y, end_x, end_y);
+    while (!search.advance(std::numeric_limits<int>::max())) {
+    }
+    return search.found;
 }
 
-// Calcola il costo del movimento (Dijkstra modificato per i buchi)
-DijkstraResult runDijkstraSearch(const std::vector<std::vector<char>>& map, int start_x, int start_y) {
-    int width = static_cast<int>(map[0].size());
-    int height = static_cast<int>(map.size());
-    
-    std::vector<std::vector<std::vector<int>>> distance(height, std::vector<std::vector<int>>(width, std::vector<int>(5, -1)));
-    std::vector<std::vector<std::vector<std::tuple<int, int, int>>>> parent(height, std::vector<std::vector<std::tuple<int, int, int>>>(width, std::vector<std::tuple<int, int, int>>(5, {-1, -1, -1})));
+// Ricerca Dijkstra riprendibile: calcola il costo del movimento (modificata per i buchi)
+template <unsigned Features = FEATURE_ALL>
+struct DijkstraSearch {
+    const std::vector<std::vector<char>>* map = nullptr;
+    DijkstraResult result;
     std::vector<std::tuple<int, int, int>> queue;
+    size_t queue_front = 0;
     
-    queue.push_back({start_x, start_y, 4});
-    distance[start_y][start_x][4] = 0;
-    
-    int dx[] = {1, -1, 0, 0};
-    int dy[] = {0, 0, 1, -1};
-    
-    int iterations = 0;
-    
-    while (!queue.empty()) {
-        iterations++;
+    void reset(const std::vector<std::vector<char>>& search_map, int start_x, int start_y) {
+        int width = static_cast<int>(search_map[0].size());
+        int height = static_cast<int>(search_map.size());
         
-        auto [x, y, last_dir] = queue.front();
-        queue.erase(queue.begin());
+        map = &search_map;
+        result.distance.assign(height, std::vector<std::vector<int>>(width, std::vector<int>(5, -1)));
+        result.parent.assign(height, std::vector<std::vector<std::tuple<int, int, int>>>(width, std::vector<std::tuple<int, int, int>>(5, {-1, -1, -1})));
+        queue.clear();
+        queue_front = 0;
         
-        for (int i = 0; i < 4; i++) {
-            auto [new_x, new_y] = simulateMove(map, x, y, dx[i], dy[i]);
-            
-            // Se non si muove o finisce in un buco, salta
-            if ((new_x == x && new_y == y) || isDeadlyTerrain(map, new_x, new_y)) {
-                continue;
-            }
-            
-            // Il costo è sempre basato sui cambi di direzione
-            int move_cost = (last_dir == 4 || last_dir != i) ? 1 : 0;
-            int new_distance = distance[y][x][last_dir] + move_cost;
+        queue.push_back({start_x, start_y, 4});
+        result.distance[start_y][start_x][4] = 0;
+    }
+    
+    // Espande al massimo max_expansions stati; restituisce true quando la ricerca è terminata
+    bool advance(int max_expansions) {
+        auto& distance = result.distance;
+        auto& parent = result.parent;
+        
+        for (int expanded = 0; expanded < max_expansions && queue_front < queue.size(); expanded++) {
+            // Stesso ordine FIFO di prima, senza il costo di erase(begin)
+            auto [x, y, last_dir] = queue[queue_front];
+            queue_front++;
             
-            if (distance[new_y][new_x][i] == -1 || distance[new_y][new_x][i] > new_distance) {
-                distance[new_y][new_x][i] = new_distance;
-                parent[new_y][new_x][i] = {x, y, last_dir};
-                queue.push_back({new_x, new_y, i});
+            for (int i = 0; i < 4; i++) {
+                auto [new_x, new_y] = simulateMove<Features>(*map, x, y, DIR_DX[i], DIR_DY[i]);
+                
+                // Se non si muove o finisce in un buco, salta
+                if ((new_x == x && new_y == y) || isDeadlyTerrainFor<Features>(*map, new_x, new_y)) {
+                    continue;
+                }
+                
+                // Il costo è sempre basato sui cambi di direzione
+                int move_cost = (last_dir == 4 || last_dir != i) ? 1 : 0;
+                int new_distance = distance[y][x][last_dir] + move_cost;
+                
+                if (distance[new_y][new_x][i] == -1 || distance[new_y][new_x][i] > new_distance) {
+                    distance[new_y][new_x][i] = new_distance;
+                    parent[new_y][new_x][i] = {x, y, last_dir};
+                    queue.push_back({new_x, new_y, i});
+                }
             }
         }
+        return queue_front >= queue.size();
+    }
+};
+
+// Calcola il costo del movimento in un'unica chiamata
+template <unsigned Features = FEATURE_ALL>
+DijkstraResult runDijkstraSearch(const std::vector<std::vector<char>>& map, int start_x, int start_y) {
+    DijkstraSearch<Features> search;
+    search.reset(map, start_x, start_y);
+    while (!search.advance(std::numeric_limits<int>::max())) {
     }
-	
-    return {distance, parent};
+    return std::move(search.result);
 }
 
 // Trova la migliore direzione finale
@@ -338,6 +469,7 @@ std::vector<int> reconstructDirectionChanges(const std::vector<std::vector<std::
 }
 
 // Ricostruisce la sequenza completa di tutte le mosse (non solo i cambi)
+template <unsigned Features = FEATURE_ALL>
 std::vector<int> reconstructFullMovePath(const std::vector<std::vector<std::vector<std::tuple<int, int, int>>>>& parent, 
                                         const std::vector<std::vector<char>>& map,
                                         int start_x, int start_y, int end_x, int end_y, int best_dir) {
@@ -360,13 +492,10 @@ std::vector<int> reconstructFullMovePath(const std::vector<std::vector<std::vect
     std::vector<int> full_moves;
     int curr_x = start_x, curr_y = start_y;
     
-    int dx[] = {1, -1, 0, 0};
-    int dy[] = {0, 0, 1, -1};
-    
     for (const auto& [target_x, target_y, direction] : path_states) {
         // Simula tutte le mosse necessarie per raggiungere questo stato
         while (curr_x != target_x || curr_y != target_y) {
-            auto [next_x, next_y] = simulateMove(map, curr_x, curr_y, dx[direction], dy[direction]);
+            auto [next_x, next_y] = simulateMove<Features>(map, curr_x, curr_y, DIR_DX[direction], DIR_DY[direction]);
             
             // Se non si muove, c'è un errore nella ricostruzione
             if (next_x == curr_x && next_y == curr_y) {
@@ -382,10 +511,10 @@ std::vector<int> reconstructFullMovePath(const std::vector<std::vector<std::vect
     return full_moves;
 }
 
-// Funzione principale per calcolare mosse minime e percorso completo
-PathResult calculateMinMovesAndPath(const std::vector<std::vector<char>>& map, int start_x, int start_y, int end_x, int end_y) {
-    // Esegui ricerca Dijkstra
-    auto search_result = runDijkstraSearch(map, start_x, start_y);
+// Ricava mosse minime e percorso completo dal risultato di una ricerca Dijkstra
+template <unsigned Features = FEATURE_ALL>
+PathResult buildPathResult(const DijkstraResult& search_result, const std::vector<std::vector<char>>& map,
+                           int start_x, int start_y, int end_x, int end_y) {
     auto& distance = search_result.distance;
     auto& parent = search_result.parent;
     
@@ -399,13 +528,423 @@ PathResult calculateMinMovesAndPath(const std::vector<std::vector<char>>& map, i
     int min_moves = distance[end_y][end_x][best_dir];
     // Se il risultato è valido, ricostruisci il percorso
     if (min_moves != -1) {
-        std::vector<int> full_path = reconstructFullMovePath(parent, map, start_x, start_y, end_x, end_y, best_dir);
+        std::vector<int> full_path = reconstructFullMovePath<Features>(parent, map, start_x, start_y, end_x, end_y, best_dir);
         return {min_moves, full_path};
     } else {
         return {-1, {}};
     }
 }
 
+// Funzione principale per calcolare mosse minime e percorso completo
+template <unsigned Features = FEATURE_ALL>
+PathResult calculateMinMovesAndPath(const std::vector<std::vector<char>>& map, int start_x, int start_y, int end_x, int end_y) {
+    // Esegui ricerca Dijkstra
+    auto search_result = runDijkstraSearch<Features>(map, start_x, start_y);
+    return buildPathResult<Features>(search_result, map, start_x, start_y, end_x, end_y);
+}
+
+// Analisi riprendibile del grafo degli stati (cella, direzione) raggiungibili da I in O(stati + archi):
+// esplorazione in avanti, raggiungibilità inversa da E (trappole) e Tarjan (cicli)
+template <unsigned Features = FEATURE_ALL>
+struct SlideGraphAnalysis {
+    static constexpr int DIRS = 5; // 4 direzioni + stato iniziale
+    
+    enum Phase { FORWARD, REVERSE_INDEX, REVERSE_BFS, TARJAN, DONE };
+    
+    const std::vector<std::vector<char>>* map = nullptr;
+    int width = 0;
+    int end_cell = 0;
+    Phase phase = DONE;
+    
+    // La destinazione di una mossa dipende solo dalla cella: ogni simulateMove viene eseguita una volta sola
+    // -2 = non ancora calcolata, -1 = mossa non valida (non si muove o finisce in un buco)
+    std::vector<int> transitions;
+    
+    // Esplorazione in avanti: stati raggiungibili e archi in formato compatto (CSR)
+    std::vector<int> state_index;
+    std::vector<int> states;
+    std::vector<int> edge_start;
+    std::vector<int> edges;
+    size_t forward_pos = 0;
+    int expandable_states = 0;
+    
+    // Archi inversi (CSR) e BFS all'indietro partendo da tutti gli stati su E
+    std::vector<int> reverse_start;
+    std::vector<int> reverse_edges;
+    std::vector<char> reaches_end;
+    std::vector<int> reverse_queue;
+    size_t reverse_pos = 0;
+    
+    // Tarjan iterativo: dimensione della componente fortemente connessa più grande
+    std::vector<int> index;
+    std::vector<int> lowlink;
+    std::vector<char> on_stack;
+    std::vector<int> scc_stack;
+    std::vector<std::pair<int, int>> call_stack; // (stato, prossimo arco da visitare)
+    int next_index = 0;
+    int tarjan_root = 0;
+    int largest_cycle = 0;
+    
+    void reset(const std::vector<std::vector<char>>& search_map, int start_x, int start_y, int end_x, int end_y) {
+        int height = static_cast<int>(search_map.size());
+        width = static_cast<int>(search_map[0].size());
+        map = &search_map;
+        end_cell = end_y * width + end_x;
+        
+        transitions.assign(width * height * 4, -2);
+        state_index.assign(width * height * DIRS, -1);
+        states.clear();
+        edge_start.clear();
+        edges.clear();
+        forward_pos = 0;
+        expandable_states = 0;
+        reverse_queue.clear();
+        reverse_pos = 0;
+        scc_stack.clear();
+        call_stack.clear();
+        next_index = 0;
+        tarjan_root = 0;
+        largest_cycle = 0;
+        
+        int start_cell = start_y * width + start_x;
+        states.push_back(start_cell * DIRS + 4);
+        state_index[start_cell * DIRS + 4] = 0;
+        phase = FORWARD;
+    }
+    
+    // Esegue al massimo max_units passi di lavoro; restituisce true quando l'analisi è completa
+    bool advance(int max_units) {
+        for (int unit = 0; unit < max_units && phase != DONE; unit++) {
+            switch (phase) {
+                case FORWARD: expandForward(); break;
+                case REVERSE_INDEX: buildReverseIndex(); break;
+                case REVERSE_BFS: expandReverse(); break;
+                case TARJAN: tarjanStep(); break;
+                case DONE: break;
+            }
+        }
+        return phase == DONE;
+    }
+    
+    SlideGraphStats stats() const {
+        int state_count = static_cast<int>(states.size());
+        int trap_states = state_count - static_cast<int>(reverse_queue.size());
+        
+        SlideGraphStats result;
+        result.reachable_states = state_count;
+        result.trap_states = trap_states;
+        result.trap_ratio = static_cast<double>(trap_states) / state_count;
+        result.mean_branching = expandable_states > 0 ? static_cast<double>(edges.size()) / expandable_states : 0.0;
+        result.largest_cycle = largest_cycle;
+        return result;
+    }
+    
+private:
+    void expandForward() {
+        if (forward_pos >= states.size()) {
+            edge_start.push_back(static_cast<int>(edges.size()));
+            phase = REVERSE_INDEX;
+            return;
+        }
+        
+        size_t s = forward_pos++;
+        edge_start.push_back(static_cast<int>(edges.size()));
+        int cell = states[s] / DIRS;
+        
+        // E è terminale: una volta raggiunta la partita finisce
+        if (cell == end_cell) {
+            return;
+        }
+        expandable_states++;
+        
+        int x = cell % width;
+        int y = cell / width;
+        
+        for (int i = 0; i < 4; i++) {
+            int& target = transitions[cell * 4 + i];
+            if (target == -2) {
+                auto [new_x, new_y] = simulateMove<Features>(*map, x, y, DIR_DX[i], DIR_DY[i]);
+                if ((new_x == x && new_y == y) || isDeadlyTerrainFor<Features>(*map, new_x, new_y)) {
+                    target = -1;
+                } else {
+                    target = new_y * width + new_x;
+                }
+            }
+            if (target == -1) {
+                continue;
+            }
+            
+            int next_state = target * DIRS + i;
+            if (state_index[next_state] == -1) {
+                state_index[next_state] = static_cast<int>(states.size());
+                states.push_back(next_state);
+            }
+            edges.push_back(state_index[next_state]);
+        }
+    }
+    
+    // Costruzione lineare degli archi inversi: un solo passo, limitato dalla dimensione della mappa
+    void buildReverseIndex() {
+        int state_count = static_cast<int>(states.size());
+        
+        reverse_start.assign(state_count + 1, 0);
+        reverse_edges.resize(edges.size());
+        for (int target : edges) {
+            reverse_start[target + 1]++;
+        }
+        for (int s = 0; s < state_count; s++) {
+            reverse_start[s + 1] += reverse_start[s];
+        }
+        std::vector<int> fill_pos(reverse_start.begin(), reverse_start.end() - 1);
+        for (int s = 0; s < state_count; s++) {
+            for (int e = edge_start[s]; e < edge_start[s + 1]; e++) {
+                reverse_edges[fill_pos[edges[e]]++] = s;
+            }
+        }
+        
+        reaches_end.assign(state_count, 0);
+        for (int s = 0; s < state_count; s++) {
+            if (states[s] / DIRS == end_cell) {
+                reaches_end[s] = 1;
+                reverse_queue.push_back(s);
+            }
+        }
+        
+        index.assign(state_count, -1);
+        lowlink.assign(state_count, 0);
+        on_stack.assign(state_count, 0);
+        phase = REVERSE_BFS;
+    }
+    
+    void expandReverse() {
+        if (reverse_pos >= reverse_queue.size()) {
+            phase = TARJAN;
+            return;
+        }
+        
+        int s = reverse_queue[reverse_pos++];
+        for (int e = reverse_start[s]; e < reverse_start[s + 1]; e++) {
+            int prev = reverse_edges[e];
+            if (!reaches_end[prev]) {
+                reaches_end[prev] = 1;
+                reverse_queue.push_back(prev);
+            }
+        }
+    }
+    
+    // Un passo di Tarjan: visita un arco oppure chiude uno stato
+    void tarjanStep() {
+        if (call_stack.empty()) {
+            int state_count = static_cast<int>(states.size());
+            while (tarjan_root < state_count && index[tarjan_root] != -1) {
+                tarjan_root++;
+            }
+            if (tarjan_root >= state_count) {
+                phase = DONE;
+                return;
+            }
+            
+            int root = tarjan_root;
+            index[root] = lowlink[root] = next_index++;
+            scc_stack.push_back(root);
+            on_stack[root] = 1;
+            call_stack.push_back({root, edge_start[root]});
+            return;
+        }
+        
+        int v = call_stack.back().first;
+        int e = call_stack.back().second;
+        
+        if (e < edge_start[v + 1]) {
+            call_stack.back().second++;
+            int w = edges[e];
+            if (index[w] == -1) {
+                index[w] = lowlink[w] = next_index++;
+                scc_stack.push_back(w);
+                on_stack[w] = 1;
+                call_stack.push_back({w, edge_start[w]});
+            } else if (on_stack[w]) {
+                lowlink[v] = std::min(lowlink[v], index[w]);
+            }
+            return;
+        }
+        
+        call_stack.pop_back();
+        if (!call_stack.empty()) {
+            int parent_state = call_stack.back().first;
+            lowlink[parent_state] = std::min(lowlink[parent_state], lowlink[v]);
+        }
+        
+        if (lowlink[v] == index[v]) {
+            int component_size = 0;
+            int w;
+            do {
+                w = scc_stack.back();
+                scc_stack.pop_back();
+                on_stack[w] = 0;
+                component_size++;
+            } while (w != v);
+            
+            // Una componente di un solo stato non è un ciclo (una mossa valida sposta sempre il giocatore)
+            if (component_size > 1) {
+                largest_cycle = std::max(largest_cycle, component_size);
+            }
+        }
+    }
+};
+
+// Analizza il grafo degli stati in un'unica chiamata
+template <unsigned Features = FEATURE_ALL>
+SlideGraphStats analyzeSlideGraph(const std::vector<std::vector<char>>& map, int start_x, int start_y, int end_x, int end_y) {
+    SlideGraphAnalysis<Features> analysis;
+    analysis.reset(map, start_x, start_y, end_x, end_y);
+    while (!analysis.advance(std::numeric_limits<int>::max())) {
+    }
+    return analysis.stats();
+}
+
+// Verifica che le statistiche del grafo rispettino i filtri di accettazione
+bool passesAcceptanceFilters(const SlideGraphStats& stats, const AcceptanceFilters& filters) {
+    if (stats.trap_ratio > filters.max_trap_ratio) {
+        return false;
+    }
+    if (stats.mean_branching < filters.min_branching) {
+        return false;
+    }
+    if (filters.max_cycle != -1 && stats.largest_cycle > filters.max_cycle) {
+        return false;
+    }
+    return true;
+}
+
+// Valutazione riprendibile di un candidato: percorso, mosse minime e filtri sul grafo degli stati
+class CandidateSearch {
+public:
+    virtual ~CandidateSearch() = default;
+    
+    virtual void reset(const std::vector<std::vector<char>>& map, int start_x, int start_y, int end_x, int end_y,
+                       int min_moves, const AcceptanceFilters& filters) = 0;
+    
+    // Esegue al massimo max_units passi di lavoro; restituisce true quando il candidato è stato valutato
+    virtual bool advance(int max_units) = 0;
+    
+    bool accepted() const { return is_accepted; }
+    const PathResult& pathResult() const { return path_result; }
+    const SlideGraphStats& stats() const { return graph_stats; }
+    
+protected:
+    bool is_accepted = false;
+    PathResult path_result = {-1, {}};
+    SlideGraphStats graph_stats = {};
+};
+
+// Specializzazione sui terreni presenti nella mappa
+template <unsigned Features>
+class CandidateSearchFor : public CandidateSearch {
+public:
+    void reset(const std::vector<std::vector<char>>& search_map, int sx, int sy, int ex, int ey,
+               int required_moves, const AcceptanceFilters& acceptance_filters) override {
+        map = &search_map;
+        start_x = sx;
+        start_y = sy;
+        end_x = ex;
+        end_y = ey;
+        min_moves = required_moves;
+        filters = &acceptance_filters;
+        
+        is_accepted = false;
+        path_result = {-1, {}};
+        graph_stats = {};
+        path_search.reset(search_map, sx, sy, ex, ey);
+        phase = PATH;
+    }
+    
+    bool advance(int max_units) override {
+        switch (phase) {
+            case PATH:
+                if (path_search.advance(max_units)) {
+                    if (path_search.found) {
+                        dijkstra_search.reset(*map, start_x, start_y);
+                        phase = DIJKSTRA;
+                    } else {
+                        phase = DONE;
+                    }
+                }
+                break;
+            case DIJKSTRA:
+                if (dijkstra_search.advance(max_units)) {
+                    path_result = buildPathResult<Features>(dijkstra_search.result, *map, start_x, start_y, end_x, end_y);
+                    
+                    // L'analisi delle trappole viene eseguita solo sui candidati già abbastanza difficili
+                    if (path_result.min_moves != -1 && path_result.min_moves >= min_moves) {
+                        analysis.reset(*map, start_x, start_y, end_x, end_y);
+                        phase = ANALYSIS;
+                    } else {
+                        phase = DONE;
+                    }
+                }
+                break;
+            case ANALYSIS:
+                if (analysis.advance(max_units)) {
+                    graph_stats = analysis.stats();
+                    is_accepted = passesAcceptanceFilters(graph_stats, *filters);
+                    phase = DONE;
+                }
+                break;
+            case DONE:
+                break;
+        }
+        return phase == DONE;
+    }
+    
+private:
+    enum Phase { PATH, DIJKSTRA, ANALYSIS, DONE };
+    
+    const std::vector<std::vector<char>>* map = nullptr;
+    const AcceptanceFilters* filters = nullptr;
+    int start_x = 0, start_y = 0, end_x = 0, end_y = 0;
+    int min_moves = 0;
+    Phase phase = DONE;
+    
+    PathSearch<Features> path_search;
+    DijkstraSearch<Features> dijkstra_search;
+    SlideGraphAnalysis<Features> analysis;
+};
+
+// Sceglie la specializzazione del solver che corrisponde ai terreni presenti
+std::unique_ptr<CandidateSearch> makeCandidateSearch(unsigned features) {
+    switch (features) {
+        case FEATURE_NONE: return std::make_unique<CandidateSearchFor<FEATURE_NONE>>();
+        case FEATURE_HOLES: return std::make_unique<CandidateSearchFor<FEATURE_HOLES>>();
+        default: return std::make_unique<CandidateSearchFor<FEATURE_ALL>>();
+    }
+}
+
+// Maschera delle caratteristiche presenti in una mappa già esistente
+unsigned detectFeatures(const std::vector<std::vector<char>>& map) {
+    unsigned features = FEATURE_NONE;
+    for (const auto& row : map) {
+        for (char cell : row) {
+            uint8_t tile = tileClass(cell);
+            if (tile & TILE_DEADLY) features |= FEATURE_HOLES;
+            if (tile & TILE_CONVEYOR) features |= FEATURE_CONVEYORS;
+        }
+    }
+    return features;
+}
+
+// Calcola mosse minime e percorso con la specializzazione più piccola che copre le caratteristiche date
+PathResult calculateMinMovesAndPathFor(unsigned features, const std::vector<std::vector<char>>& map,
+                                       int start_x, int start_y, int end_x, int end_y) {
+    if (features & FEATURE_CONVEYORS) {
+        return calculateMinMovesAndPath<FEATURE_ALL>(map, start_x, start_y, end_x, end_y);
+    }
+    if (features & FEATURE_HOLES) {
+        return calculateMinMovesAndPath<FEATURE_HOLES>(map, start_x, start_y, end_x, end_y);
+    }
+    return calculateMinMovesAndPath<FEATURE_NONE>(map, start_x, start_y, end_x, end_y);
+}
+
 // Inizializza una mappa vuota con bordi di muri
 std::vector<std::vector<char>> createEmptyMap(int width, int height) {
     std::vector<std::vector<char>> map(height, std::vector<char>(width, 'M'));
@@ -437,77 +976,353 @@ void placeStartAndEnd(std::vector<std::vector<char>>& map, std::mt19937& rng,
     map[end_y][end_x] = 'E';
 }
 
-// Aggiunge terreno normale casualmente
-void addNormalTerrain(std::vector<std::vector<char>>& map, std::mt19937& rng, 
-                     int difficulty, int start_x, int start_y, int end_x, int end_y) {
-    int width = static_cast<int>(map[0].size());
-    int height = static_cast<int>(map.size());
-    int normal_terrain_count = (width * height) / (35 + difficulty * 5);
+// Vincoli del motore di piazzamento
+struct PlacementConstraints {
+    int hole_min_distance = 1;          // Distanza minima (Chebyshev) dei buchi da I ed E (1 = solo I/E escluse)
+    int max_wall_cluster = -1;          // Celle massime di un gruppo di muri interni (-1 = nessun limite)
+    int region_size = 8;                // Lato delle regioni per la densità (0 = nessun limite per regione)
+    double region_density_slack = 2.0;  // Quota per regione rispetto alla densità media del passaggio
+};
+
+// Insieme indicizzato di celle: inserimento, rimozione (scambio con l'ultimo) ed estrazione casuale in O(1)
+class IndexedCellSet {
+public:
+    void reset(int cell_count) {
+        cells.clear();
+        cells.reserve(cell_count);
+        position.assign(cell_count, -1);
+    }
     
-    for (int i = 0; i < normal_terrain_count; i++) {
-        int x, y;
-        int attempts = 0;
-        do {
-            x = 1 + rng() % (width - 2);
-            y = 1 + rng() % (height - 2);
-            attempts++;
-        } while ((map[y][x] != 'G' || (x == start_x && y == start_y) || (x == end_x && y == end_y)) && attempts < 50);
-        
-        if (attempts < 50) {
-            map[y][x] = 'T';
+    bool contains(int cell) const { return position[cell] != -1; }
+    int size() const { return static_cast<int>(cells.size()); }
+    
+    void insert(int cell) {
+        if (contains(cell)) {
+            return;
         }
+        position[cell] = static_cast<int>(cells.size());
+        cells.push_back(cell);
     }
-}
-
-// Aggiunge ostacoli di varie dimensioni
-void addObstacles(std::vector<std::vector<char>>& map, std::mt19937& rng, 
-                 int difficulty, int start_x, int start_y, int end_x, int end_y) {
-    int width = static_cast<int>(map[0].size());
-    int height = static_cast<int>(map.size());
-    int internal_walls = difficulty * 5 + (width * height) / 25;
     
-    for (int i = 0; i < internal_walls; i++) {
-        int x, y;
-        int attempts = 0;
-        do {
-            x = 1 + rng() % (width - 2);
-            y = 1 + rng() % (height - 2);
-            attempts++;
-        } while ((map[y][x] != 'G' || (x == start_x && y == start_y) || (x == end_x && y == end_y)) && attempts < 100);
-        
-        if (attempts < 100) {
-            int obstacle_size = 1 + rng() % 3; // 1x1, 2x2, o 3x3
-            
-            for (int dy = 0; dy < obstacle_size && y + dy < height - 1; dy++) {
-                for (int dx = 0; dx < obstacle_size && x + dx < width - 1; dx++) {
-                    if (map[y + dy][x + dx] == 'G') {
-                        map[y + dy][x + dx] = 'M';
-                    }
+    void erase(int cell) {
+        int pos = position[cell];
+        if (pos == -1) {
+            return;
+        }
+        int last = cells.back();
+        cells[pos] = last;
+        position[last] = pos;
+        cells.pop_back();
+        position[cell] = -1;
+    }
+    
+    int sample(std::mt19937& rng) const {
+        return cells[rng() % cells.size()];
+    }
+    
+private:
+    std::vector<int> cells;
+    std::vector<int> position;
+};
+
+// Motore di piazzamento condiviso dalle funzioni add*: mantiene l'insieme delle celle di ghiaccio libere,
+// così ogni piazzamento è O(1) (ammortizzato) invece di un campionamento con rifiuto che rinuncia dopo 50 tentativi.
+// Ogni tipo di terreno è un passaggio: beginPass() applica i vincoli, endPass() rimette le celle escluse.
+class PlacementEngine {
+public:
+    PlacementEngine(std::vector<std::vector<char>>& placement_map, int sx, int sy, int ex, int ey,
+                    const PlacementConstraints& placement_constraints)
+        : map(placement_map), start_x(sx), start_y(sy), end_x(ex), end_y(ey), constraints(placement_constraints) {
+        height = static_cast<int>(map.size());
+        width = static_cast<int>(map[0].size());
+        
+        free_cells.reset(width * height);
+        
+        // I gruppi di muri vengono tracciati solo se il vincolo è attivo
+        if (constraints.max_wall_cluster >= 0) {
+            wall_parent.assign(width * height, -1);
+            wall_size.assign(width * height, 0);
+        }
+        
+        for (int y = 1; y < height - 1; y++) {
+            for (int x = 1; x < width - 1; x++) {
+                if (map[y][x] == 'G') {
+                    free_cells.insert(y * width + x);
                 }
             }
         }
+        
+        // Regioni quadrate sull'interno della mappa (una sola se non c'è un limite di densità)
+        region_side = constraints.region_size > 0 ? constraints.region_size : std::max(width, height);
+        regions_x = (width - 2 + region_side - 1) / region_side;
+        int regions_y = (height - 2 + region_side - 1) / region_side;
+        region_quota.assign(regions_x * regions_y, 0);
+        region_used.assign(regions_x * regions_y, 0);
     }
-}
-
-// Aggiunge muri singoli sparsi
-void addScatteredWalls(std::vector<std::vector<char>>& map, std::mt19937& rng) {
-    int width = static_cast<int>(map[0].size());
-    int height = static_cast<int>(map.size());
-    int single_walls = (width * height) / 15;
     
-    for (int i = 0; i < single_walls; i++) {
-        int x = 1 + rng() % (width - 2);
-        int y = 1 + rng() % (height - 2);
+    // Prepara un passaggio di `count` piazzamenti: quote per regione ed esclusione attorno a I/E
+    void beginPass(int count, int min_distance) {
+        int interior_cells = (width - 2) * (height - 2);
+        for (size_t r = 0; r < region_quota.size(); r++) {
+            region_used[r] = 0;
+            if (constraints.region_size > 0) {
+                // Regioni sul bordo destro/inferiore possono essere più piccole
+                int first_x = 1 + (static_cast<int>(r) % regions_x) * region_side;
+                int first_y = 1 + (static_cast<int>(r) / regions_x) * region_side;
+                int cells = (std::min(first_x + region_side, width - 1) - first_x) *
+                            (std::min(first_y + region_side, height - 1) - first_y);
+                double share = static_cast<double>(count) * cells / interior_cells;
+                region_quota[r] = std::max(1, static_cast<int>(std::ceil(share * constraints.region_density_slack)));
+            } else {
+                region_quota[r] = std::numeric_limits<int>::max();
+            }
+        }
         
-        if (map[y][x] == 'G') {
-            map[y][x] = 'M';
+        excludeAround(start_x, start_y, min_distance);
+        excludeAround(end_x, end_y, min_distance);
+    }
+    
+    // Estrae una cella libera che rispetta i vincoli del passaggio; false se non ce ne sono più.
+    // Le celle di una regione piena vengono scartate solo quando estratte: ogni cella esce al più
+    // una volta per passaggio, quindi il costo resta O(1) ammortizzato.
+    bool takeCell(std::mt19937& rng, int& x, int& y) {
+        while (free_cells.size() > 0) {
+            int cell = free_cells.sample(rng);
+            free_cells.erase(cell);
+            excluded.push_back(cell);
+            x = cell % width;
+            y = cell / width;
+            
+            int region = regionOf(x, y);
+            if (region_used[region] < region_quota[region]) {
+                return true;
+            }
         }
+        return false;
     }
+    
+    // Estrazione uniforme su tutto l'interno come nel campionamento originale: true se cade su ghiaccio
+    // libero (probabilità celle libere / celle interne), senza dover cercare la cella estratta
+    bool drawHitsFreeCell(std::mt19937& rng) const {
+        int interior_cells = (width - 2) * (height - 2);
+        return static_cast<int>(rng() % interior_cells) < free_cells.size();
+    }
+    
+    // Conta un piazzamento riuscito nella sua regione. Le celle estratte e poi scartate
+    // (es. vincolo sui gruppi di muri violato) restano escluse fino alla fine del passaggio.
+    void commitPlacement(int x, int y) {
+        region_used[regionOf(x, y)]++;
+    }
+    
+    // Verifica che aggiungere questi muri non crei un gruppo più grande del limite
+    bool fitsWallCluster(const int* cells, int cell_count) {
+        if (constraints.max_wall_cluster < 0) {
+            return true;
+        }
+        
+        int roots[36];
+        int root_count = 0;
+        int total = cell_count;
+        
+        for (int i = 0; i < cell_count; i++) {
+            int x = cells[i] % width;
+            int y = cells[i] / width;
+            for (int dir = 0; dir < 4; dir++) {
+                int neighbor = (y + DIR_DY[dir]) * width + (x + DIR_DX[dir]);
+                if (wall_parent[neighbor] == -1) {
+                    continue;
+                }
+                int root = findWallRoot(neighbor);
+                if (std::find(roots, roots + root_count, root) == roots + root_count) {
+                    roots[root_count++] = root;
+                    total += wall_size[root];
+                }
+            }
+        }
+        return total <= constraints.max_wall_cluster;
+    }
+    
+    // Piazza un terreno su una cella di ghiaccio e aggiorna l'insieme delle celle libere
+    void placeTile(int x, int y, char tile) {
+        int cell = y * width + x;
+        map[y][x] = tile;
+        free_cells.erase(cell);
+        
+        if (tile == 'M' && constraints.max_wall_cluster >= 0) {
+            wall_parent[cell] = cell;
+            wall_size[cell] = 1;
+            for (int dir = 0; dir < 4; dir++) {
+                int neighbor = (y + DIR_DY[dir]) * width + (x + DIR_DX[dir]);
+                if (wall_parent[neighbor] != -1) {
+                    uniteWalls(cell, neighbor);
+                }
+            }
+        }
+    }
+    
+    // Rimette a disposizione le celle escluse durante il passaggio che sono ancora ghiaccio
+    void endPass() {
+        for (int cell : excluded) {
+            if (map[cell / width][cell % width] == 'G') {
+                free_cells.insert(cell);
+            }
+        }
+        excluded.clear();
+    }
+    
+private:
+    int regionOf(int x, int y) const {
+        return ((y - 1) / region_side) * regions_x + (x - 1) / region_side;
+    }
+    
+    void excludeAround(int center_x, int center_y, int min_distance) {
+        for (int y = center_y - min_distance + 1; y < center_y + min_distance; y++) {
+            for (int x = center_x - min_distance + 1; x < center_x + min_distance; x++) {
+                if (!isValidPosition(x, y, width, height)) {
+                    continue;
+                }
+                int cell = y * width + x;
+                if (free_cells.contains(cell)) {
+                    free_cells.erase(cell);
+                    excluded.push_back(cell);
+                }
+            }
+        }
+    }
+    
+    // Union-find sui soli muri interni (il bordo non conta come ostacolo)
+    int findWallRoot(int cell) {
+        while (wall_parent[cell] != cell) {
+            wall_parent[cell] = wall_parent[wall_parent[cell]];
+            cell = wall_parent[cell];
+        }
+        return cell;
+    }
+    
+    void uniteWalls(int a, int b) {
+        a = findWallRoot(a);
+        b = findWallRoot(b);
+        if (a == b) {
+            return;
+        }
+        if (wall_size[a] < wall_size[b]) {
+            std::swap(a, b);
+        }
+        wall_parent[b] = a;
+        wall_size[a] += wall_size[b];
+    }
+    
+    std::vector<std::vector<char>>& map;
+    int width = 0;
+    int height = 0;
+    int start_x, start_y, end_x, end_y;
+    PlacementConstraints constraints;
+    
+    IndexedCellSet free_cells;
+    std::vector<int> excluded;
+    
+    std::vector<int> wall_parent;
+    std::vector<int> wall_size;
+    
+    int region_side = 0;
+    int regions_x = 0;
+    std::vector<int> region_quota;
+    std::vector<int> region_used;
+};
+
+// Piazza `count` celle di un singolo terreno
+void placeSingleTiles(PlacementEngine& engine, std::mt19937& rng, int count, int min_distance, char tile) {
+    engine.beginPass(count, min_distance);
+    for (int i = 0; i < count; i++) {
+        int x, y;
+        if (!engine.takeCell(rng, x, y)) {
+            break;
+        }
+        engine.placeTile(x, y, tile);
+        engine.commitPlacement(x, y);
+    }
+    engine.endPass();
+}
+
+// Aggiunge terreno normale casualmente
+void addNormalTerrain(std::vector<std::vector<char>>& map, std::mt19937& rng, int difficulty, PlacementEngine& engine) {
+    int width = static_cast<int>(map[0].size());
+    int height = static_cast<int>(map.size());
+    int normal_terrain_count = (width * height) / (35 + difficulty * 5);
+    
+    placeSingleTiles(engine, rng, normal_terrain_count, 1, 'T');
+}
+
+// Aggiunge ostacoli di varie dimensioni
+void addObstacles(std::vector<std::vector<char>>& map, std::mt19937& rng, int difficulty, PlacementEngine& engine) {
+    int width = static_cast<int>(map[0].size());
+    int height = static_cast<int>(map.size());
+    int internal_walls = difficulty * 5 + (width * height) / 25;
+    
+    engine.beginPass(internal_walls, 1);
+    for (int placed = 0; placed < internal_walls; ) {
+        int x, y;
+        if (!engine.takeCell(rng, x, y)) {
+            break;
+        }
+        
+        int obstacle_size = 1 + rng() % 3; // 1x1, 2x2, o 3x3
+        int block[9];
+        int block_count = 0;
+        
+        for (int dy = 0; dy < obstacle_size && y + dy < height - 1; dy++) {
+            for (int dx = 0; dx < obstacle_size && x + dx < width - 1; dx++) {
+                if (map[y + dy][x + dx] == 'G') {
+                    block[block_count++] = (y + dy) * width + (x + dx);
+                }
+            }
+        }
+        
+        if (!engine.fitsWallCluster(block, block_count)) {
+            continue;
+        }
+        
+        for (int i = 0; i < block_count; i++) {
+            engine.placeTile(block[i] % width, block[i] / width, 'M');
+        }
+        engine.commitPlacement(x, y);
+        placed++;
+    }
+    engine.endPass();
+}
+
+// Aggiunge muri singoli sparsi
+void addScatteredWalls(std::vector<std::vector<char>>& map, std::mt19937& rng, PlacementEngine& engine) {
+    int width = static_cast<int>(map[0].size());
+    int height = static_cast<int>(map.size());
+    int single_walls = (width * height) / 15;
+    
+    // single_walls è il numero di estrazioni, non di muri: come nell'originale un'estrazione che non
+    // cade su ghiaccio libero va persa, così la densità dei muri resta quella su cui sono tarati i limiti
+    engine.beginPass(single_walls, 1);
+    for (int draw = 0; draw < single_walls; draw++) {
+        int x, y;
+        if (!engine.drawHitsFreeCell(rng)) {
+            continue;
+        }
+        if (!engine.takeCell(rng, x, y)) {
+            break;
+        }
+        
+        int cell = y * width + x;
+        if (!engine.fitsWallCluster(&cell, 1)) {
+            continue;
+        }
+        
+        engine.placeTile(x, y, 'M');
+        engine.commitPlacement(x, y);
+    }
+    engine.endPass();
 }
 
 // Aggiunge buchi mortali (solo per difficoltà 3+)
-void addDeadlyHoles(std::vector<std::vector<char>>& map, std::mt19937& rng, 
-                   int difficulty, int start_x, int start_y, int end_x, int end_y) {
+void addDeadlyHoles(std::vector<std::vector<char>>& map, std::mt19937& rng, int difficulty,
+                    PlacementEngine& engine, const PlacementConstraints& constraints) {
     // Buchi solo dalla difficoltà 3 in su
     if (difficulty < 3) {
         return;
@@ -519,24 +1334,11 @@ void addDeadlyHoles(std::vector<std::vector<char>>& map, std::mt19937& rng,
     // Numero di buchi basato sulla difficoltà: più è difficile, più buchi ci sono
     int hole_count = (difficulty - 2) * 2 + (width * height) / 100;
     
-    for (int i = 0; i < hole_count; i++) {
-        int x, y;
-        int attempts = 0;
-        do {
-            x = 1 + rng() % (width - 2);
-            y = 1 + rng() % (height - 2);
-            attempts++;
-        } while ((map[y][x] != 'G' || (x == start_x && y == start_y) || (x == end_x && y == end_y)) && attempts < 50);
-        
-        if (attempts < 50) {
-            map[y][x] = 'B';
-        }
-    }
+    placeSingleTiles(engine, rng, hole_count, constraints.hole_min_distance, 'B');
 }
 
 // Aggiunge ghiaccio fragile (solo per difficoltà 2+)
-void addFragileIce(std::vector<std::vector<char>>& map, std::mt19937& rng, 
-                   int difficulty, int start_x, int start_y, int end_x, int end_y) {
+void addFragileIce(std::vector<std::vector<char>>& map, std::mt19937& rng, int difficulty, PlacementEngine& engine) {
     // Ghiaccio fragile dalla difficoltà 2 in su
     if (difficulty < 2) {
         return;
@@ -548,23 +1350,10 @@ void addFragileIce(std::vector<std::vector<char>>& map, std::mt19937& rng,
     // Numero di piastrelle fragili basato sulla difficoltà
     int fragile_count = (difficulty - 1) * 3 + (width * height) / 80;
     
-    for (int i = 0; i < fragile_count; i++) {
-        int x, y;
-        int attempts = 0;
-        do {
-            x = 1 + rng() % (width - 2);
-            y = 1 + rng() % (height - 2);
-            attempts++;
-        } while ((map[y][x] != 'G' || (x == start_x && y == start_y) || (x == end_x && y == end_y)) && attempts < 50);
-        
-        if (attempts < 50) {
-            map[y][x] = 'D';
-        }
-    }
+    placeSingleTiles(engine, rng, fragile_count, 1, 'D');
 }
 // Aggiunge nastri trasportatori (solo per difficoltà 4+)
-void addConveyorBelts(std::vector<std::vector<char>>& map, std::mt19937& rng, 
-                      int difficulty, int start_x, int start_y, int end_x, int end_y) {
+void addConveyorBelts(std::vector<std::vector<char>>& map, std::mt19937& rng, int difficulty, PlacementEngine& engine) {
     // Nastri trasportatori dalla difficoltà 4 in su
     if (difficulty < 4) {
         return;
@@ -576,62 +1365,204 @@ void addConveyorBelts(std::vector<std::vector<char>>& map, std::mt19937& rng,
     // Numero di nastri basato sulla difficoltà
     int conveyor_count = (difficulty - 3) * 2 + (width * height) / 120;
     
-    // Array per le direzioni: destra, sinistra, giù, su
-    int conv_dx[] = {1, -1, 0, 0};
-    int conv_dy[] = {0, 0, 1, -1};
-    
-    for (int i = 0; i < conveyor_count; i++) {
+    engine.beginPass(conveyor_count, 1);
+    for (int placed = 0; placed < conveyor_count; ) {
         int x, y;
-        int attempts = 0;
-        do {
-            x = 1 + rng() % (width - 2);
-            y = 1 + rng() % (height - 2);
-            attempts++;
-        } while ((map[y][x] != 'G' || (x == start_x && y == start_y) || (x == end_x && y == end_y)) && attempts < 50);
-        
-        if (attempts < 50) {
-            // Trova tutte le direzioni valide (che non puntano verso un muro)
-            std::vector<int> valid_directions;
-            
-            for (int dir = 0; dir < 4; dir++) {
-                int target_x = x + conv_dx[dir];
-                int target_y = y + conv_dy[dir];
-                
-                // Controlla se la posizione target è valida e non è un muro
-                if (isValidPosition(target_x, target_y, width, height) && !isWall(map, target_x, target_y)) {
-                    valid_directions.push_back(dir + 1); // +1 perché i nastri usano 1-4, non 0-3
-                }
-            }
+        if (!engine.takeCell(rng, x, y)) {
+            break;
+        }
+        
+        // Trova tutte le direzioni valide (che non puntano verso un muro)
+        int valid_directions[4];
+        int valid_count = 0;
+        
+        for (int dir = 0; dir < 4; dir++) {
+            int target_x = x + DIR_DX[dir];
+            int target_y = y + DIR_DY[dir];
             
-            // Se ci sono direzioni valide, scegline una casualmente
-            if (!valid_directions.empty()) {
-                int random_index = rng() % valid_directions.size();
-                int direction = valid_directions[random_index];
-                map[y][x] = '0' + direction; // Converte numero in carattere
+            // Controlla se la posizione target è valida e non è un muro
+            if (isValidPosition(target_x, target_y, width, height) && !isWall(map, target_x, target_y)) {
+                valid_directions[valid_count++] = dir + 1; // +1 perché i nastri usano 1-4, non 0-3
             }
-            // Se non ci sono direzioni valide, non piazzare il nastro (rimane 'G')
         }
+        
+        // Se non ci sono direzioni valide, la cella resta ghiaccio e si prova un'altra cella
+        if (valid_count == 0) {
+            continue;
+        }
+        
+        int direction = valid_directions[rng() % valid_count];
+        engine.placeTile(x, y, static_cast<char>('0' + direction)); // Converte numero in carattere
+        engine.commitPlacement(x, y);
+        placed++;
     }
+    engine.endPass();
 }
 // Genera una singola mappa con tutti gli elementi (aggiornata per nastri trasportatori)
 std::vector<std::vector<char>> generateSingleMap(std::mt19937& rng, int width, int height, int difficulty,
+                                                const PlacementConstraints& constraints,
                                                 int& start_x, int& start_y, int& end_x, int& end_y) {
     auto map = createEmptyMap(width, height);
     placeStartAndEnd(map, rng, start_x, start_y, end_x, end_y);
-    addNormalTerrain(map, rng, difficulty, start_x, start_y, end_x, end_y);
-    addObstacles(map, rng, difficulty, start_x, start_y, end_x, end_y);
-    addScatteredWalls(map, rng);
-    addFragileIce(map, rng, difficulty, start_x, start_y, end_x, end_y);
-    addConveyorBelts(map, rng, difficulty, start_x, start_y, end_x, end_y);
-    addDeadlyHoles(map, rng, difficulty, start_x, start_y, end_x, end_y);
+    
+    PlacementEngine engine(map, start_x, start_y, end_x, end_y, constraints);
+    
+    addNormalTerrain(map, rng, difficulty, engine);
+    addObstacles(map, rng, difficulty, engine);
+    addScatteredWalls(map, rng, engine);
+    addFragileIce(map, rng, difficulty, engine);
+    addConveyorBelts(map, rng, difficulty, engine);
+    addDeadlyHoles(map, rng, difficulty, engine, constraints);
     
     return map;
 }
 
+// Parametri di una generazione
+struct GenerationParams {
+    int difficulty = 1;
+    uint64_t seed = 0;              // Seme del generatore casuale (entrambe le metà entrano nello stato)
+    AcceptanceFilters filters;
+    PlacementConstraints placement;
+    int max_attempts = 1000;        // Limite massimo tentativi
+};
+
+enum class GenerationStatus { PENDING, DONE, FAILED, CANCELLED };
+
+// Mappa accettata con le sue statistiche
+struct GenerationResult {
+    std::vector<std::vector<char>> map;
+    PathResult path = {-1, {}};
+    SlideGraphStats stats = {};
+    int width = 0;
+    int height = 0;
+    int difficulty = 0;
+    int attempts = 0;
+};
+
+// Avanzamento di una generazione in corso
+struct GenerationProgress {
+    int attempts;
+    int max_attempts;
+    double fraction;    // Tentativi usati rispetto al massimo (limite superiore del lavoro rimasto)
+};
+
+// Generatore riprendibile: begin(), poi step() a fette di tempo finché non restituisce DONE/FAILED/CANCELLED.
+// Tutto lo stato (mappa corrente e frontiere di ricerca) resta nell'oggetto tra una chiamata e l'altra,
+// così un host single-thread (build web senza thread) può distribuire la generazione su più frame.
+class MapGenerator {
+public:
+    // Numero di passi di lavoro tra due controlli dell'orologio
+    static constexpr int SLICE_UNITS = 32;
+    
+    void begin(const GenerationParams& generation_params) {
+        params = generation_params;
+        std::seed_seq seed_sequence{static_cast<uint32_t>(params.seed), static_cast<uint32_t>(params.seed >> 32)};
+        rng.seed(seed_sequence);
+        
+        // Parametri configurabili basati sulla difficoltà
+        const int MIN_SIZE = 8 + params.difficulty * 2;        // 10-18
+        const int MAX_SIZE = 15 + params.difficulty * 8;       // 23-55
+        min_moves = params.difficulty * 5 + 3;                 // 8-28 mosse minime
+        
+        // Genera dimensioni casuali
+        width = MIN_SIZE + (rng() % (MAX_SIZE - MIN_SIZE + 1));
+        height = MIN_SIZE + (rng() % (MAX_SIZE - MIN_SIZE + 1));
+        
+        search = makeCandidateSearch(featuresForDifficulty(params.difficulty));
+        attempts = 0;
+        candidate_pending = false;
+        cancel_requested = false;
+        generation_result = GenerationResult();
+        status = GenerationStatus::PENDING;
+    }
+    
+    // Lavora per circa budget_us microsecondi (almeno una fetta) e restituisce lo stato corrente
+    GenerationStatus step(long long budget_us) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget_us);
+        
+        while (status == GenerationStatus::PENDING) {
+            if (cancel_requested) {
+                status = GenerationStatus::CANCELLED;
+                break;
+            }
+            
+            if (!candidate_pending) {
+                // Controllo limite tentativi
+                if (attempts >= params.max_attempts) {
+                    status = GenerationStatus::FAILED;
+                    break;
+                }
+                attempts++;
+                
+                // Genera una nuova mappa
+                map = generateSingleMap(rng, width, height, params.difficulty, params.placement, start_x, start_y, end_x, end_y);
+                search->reset(map, start_x, start_y, end_x, end_y, min_moves, params.filters);
+                candidate_pending = true;
+            } else if (search->advance(SLICE_UNITS)) {
+                candidate_pending = false;
+                if (search->accepted()) {
+                    finish();
+                    break;
+                }
+            }
+            
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+        }
+        
+        return status;
+    }
+    
+    // Può essere chiamata anche da un altro thread: la generazione si ferma al prossimo step()
+    void cancel() {
+        cancel_requested = true;
+    }
+    
+    GenerationStatus currentStatus() const { return status; }
+    const GenerationResult& result() const { return generation_result; }
+    
+    GenerationProgress progress() const {
+        return {attempts, params.max_attempts, static_cast<double>(attempts) / params.max_attempts};
+    }
+    
+private:
+    void finish() {
+        generation_result.map = std::move(map);
+        generation_result.path = search->pathResult();
+        generation_result.stats = search->stats();
+        generation_result.width = width;
+        generation_result.height = height;
+        generation_result.difficulty = params.difficulty;
+        generation_result.attempts = attempts;
+        status = GenerationStatus::DONE;
+    }
+    
+    GenerationParams params;
+    std::mt19937 rng;
+    int width = 0;
+    int height = 0;
+    int min_moves = 0;
+    
+    std::vector<std::vector<char>> map;
+    int start_x = 0, start_y = 0, end_x = 0, end_y = 0;
+    int attempts = 0;
+    bool candidate_pending = false;
+    std::unique_ptr<CandidateSearch> search;
+    
+    std::atomic<bool> cancel_requested{false};
+    GenerationStatus status = GenerationStatus::FAILED;
+    GenerationResult generation_result;
+};
+
 // Stampa informazioni sulla mappa generata
-void printMapInfo(int count, const PathResult& result) {
+void printMapInfo(int count, const PathResult& result, const SlideGraphStats& stats) {
     std::cout << "Mappa valida trovata dopo " << count << " tentativi." << std::endl;
     std::cout << "Numero minimo di mosse richieste (cambi direzione): " << result.min_moves << std::endl;
+    std::cout << "Stati raggiungibili: " << stats.reachable_states
+              << ", trappole: " << stats.trap_states << " (" << stats.trap_ratio * 100.0 << "%)"
+              << ", ramificazione media: " << stats.mean_branching
+              << ", ciclo piu grande: " << stats.largest_cycle << std::endl;
     std::cout << "Sequenza completa di direzioni (" << result.full_path.size() << " mosse totali):" << std::endl;
     
     for (size_t i = 0; i < result.full_path.size(); i++) {
@@ -640,8 +1571,8 @@ void printMapInfo(int count, const PathResult& result) {
 }
 
 // Scrive l'header del file mappa (aggiornato per ghiaccio fragile)
-void writeMapHeader(std::ofstream& file, int difficulty, const PathResult& result, 
-                   int width, int height) {
+void writeMapHeader(std::ostream& file, int difficulty, const PathResult& result, 
+                   const SlideGraphStats& stats, int width, int height) {
     file << "# Mappa generata con difficolta: " << difficulty << std::endl;
     file << "# Terreni: M=Muro, G=Ghiaccio, T=Terreno normale, I=Ingresso, E=Uscita";
     if (difficulty >= 2) {
@@ -662,6 +1593,10 @@ void writeMapHeader(std::ofstream& file, int difficulty, const PathResult& resul
         file << directionToString(result.full_path[i]);
     }
     file << std::endl;
+    file << "# Analisi stati: raggiungibili=" << stats.reachable_states
+         << ", trappole=" << stats.trap_states
+         << ", ramificazione_media=" << stats.mean_branching
+         << ", ciclo_massimo=" << stats.largest_cycle << std::endl;
     file << "width=" << width << std::endl;
     file << "height=" << height << std::endl;
     file << "difficulty=" << difficulty << std::endl;
@@ -671,7 +1606,7 @@ void writeMapHeader(std::ofstream& file, int difficulty, const PathResult& resul
 }
 
 // Scrive la griglia della mappa
-void writeMapGrid(std::ofstream& file, const std::vector<std::vector<char>>& map) {
+void writeMapGrid(std::ostream& file, const std::vector<std::vector<char>>& map) {
     int height = static_cast<int>(map.size());
     int width = static_cast<int>(map[0].size());
     
@@ -684,71 +1619,1074 @@ void writeMapGrid(std::ofstream& file, const std::vector<std::vector<char>>& map
 }
 
 // Funzione principale di generazione mappa
-void generateMap(std::ofstream& file, int difficulty) {
+void generateMap(std::ofstream& file, int difficulty, const AcceptanceFilters& filters,
+                 const PlacementConstraints& placement) {
     // Validazione difficoltà
     if (difficulty < 1 || difficulty > 5) {
         std::cerr << "Errore: la difficolta deve essere tra 1 e 5." << std::endl;
         return;
     }
     
-    // Parametri configurabili basati sulla difficoltà
-    const int MIN_SIZE = 8 + difficulty * 2;        // 10-18
-    const int MAX_SIZE = 15 + difficulty * 8;       // 23-55
-    const int MIN_MOVES = difficulty * 5 + 3;       // 8-28 mosse minime
-    const int MAX_ATTEMPTS = 1000;                  // Limite massimo tentativi
+    GenerationParams params;
+    params.difficulty = difficulty;
+    params.seed = static_cast<uint64_t>(std::time(nullptr));
+    params.filters = filters;
+    params.placement = placement;
+    
+    MapGenerator generator;
+    generator.begin(params);
+    
+    // Genera mappe finché non ne trovi una valida, sufficientemente difficile e che rispetti i filtri
+    int last_reported = 0;
+    GenerationStatus status;
+    while ((status = generator.step(50000)) == GenerationStatus::PENDING) {
+        // Mostra progresso ogni 100 tentativi
+        GenerationProgress progress = generator.progress();
+        if (progress.attempts / 100 > last_reported / 100) {
+            last_reported = progress.attempts;
+            std::cout << "Tentativo " << (progress.attempts / 100) * 100 << "/" << progress.max_attempts << "..." << std::endl;
+        }
+    }
+    
+    if (status != GenerationStatus::DONE) {
+        std::cerr << "Errore: impossibile generare una mappa valida dopo " << params.max_attempts << " tentativi." << std::endl;
+        std::cerr << "Prova a ridurre la difficolta o modificare i parametri." << std::endl;
+        exit(-104);
+    }
+    
+    // Stampa informazioni e scrivi file
+    const GenerationResult& result = generator.result();
+    printMapInfo(result.attempts, result.path, result.stats);
+    writeMapHeader(file, difficulty, result.path, result.stats, result.width, result.height);
+    writeMapGrid(file, result.map);
+}
+
+// File mappato in memoria in sola lettura (lettura completa dove mmap non è disponibile)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return;
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+        opened = true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) == 0) {
+            length = static_cast<size_t>(info.st_size);
+            if (length == 0) {
+                opened = true;
+            } else {
+                void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped != MAP_FAILED) {
+                    bytes = static_cast<const char*>(mapped);
+                    opened = true;
+                }
+            }
+        }
+        ::close(fd);
+#endif
+    }
+    
+    ~MappedFile() {
+#ifndef _WIN32
+        if (bytes != nullptr) {
+            ::munmap(const_cast<char*>(bytes), length);
+        }
+#endif
+    }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool isOpen() const { return opened; }
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+    std::vector<char> buffer;
+};
+
+// Contenuto di un file .map letto dal parser nativo (-1 = campo assente nell'header)
+struct ParsedMap {
+    std::vector<std::vector<char>> grid;
+    int width = -1;
+    int height = -1;
+    int difficulty = -1;
+    int min_moves = -1;
+    int total_moves = -1;
+    int start_x = -1, start_y = -1, end_x = -1, end_y = -1;
+    uint64_t grid_hash = 14695981039346656037ull; // FNV-1a della griglia
+};
+
+// Caratteri di griglia accettati dal gioco (GlobalVariables.tile_mapping).
+// 'X' è solo uno stato interno del solver, quindi una mappa che lo contiene non è valida.
+bool isGameTile(char cell) {
+    return cell != '\0' && std::strchr("MGTIEBD1234", cell) != nullptr;
+}
+
+// Parser di un file .map in memoria, con le stesse regole di map_manager.gd:
+// righe vuote o con '#' ignorate, righe con '=' come metadati, le altre come griglia.
+// Restituisce un messaggio d'errore, vuoto se la mappa è giocabile.
+std::string parseMapBuffer(const char* data, size_t size, ParsedMap& parsed) {
+    const char* cursor = data;
+    const char* end = data + size;
+    
+    while (cursor < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        
+        // Rimuove spazi e '\r' ai bordi
+        const char* first = cursor;
+        const char* last = line_end;
+        while (first < last && std::isspace(static_cast<unsigned char>(*first))) first++;
+        while (last > first && std::isspace(static_cast<unsigned char>(*(last - 1)))) last--;
+        cursor = line_end + 1;
+        
+        if (first == last || *first == '#') {
+            continue;
+        }
+        
+        const char* equals = static_cast<const char*>(std::memchr(first, '=', last - first));
+        if (equals != nullptr) {
+            const char* key_end = equals;
+            while (key_end > first && std::isspace(static_cast<unsigned char>(*(key_end - 1)))) key_end--;
+            const char* value = equals + 1;
+            while (value < last && std::isspace(static_cast<unsigned char>(*value))) value++;
+            
+            std::string key(first, key_end);
+            int number = -1;
+            std::from_chars(value, last, number);
+            
+            if (key == "width") parsed.width = number;
+            else if (key == "height") parsed.height = number;
+            else if (key == "difficulty") parsed.difficulty = number;
+            else if (key == "min_moves") parsed.min_moves = number;
+            else if (key == "total_moves") parsed.total_moves = number;
+            continue;
+        }
+        
+        int y = static_cast<int>(parsed.grid.size());
+        std::vector<char> row(first, last);
+        for (int x = 0; x < static_cast<int>(row.size()); x++) {
+            char cell = row[x];
+            if (!isGameTile(cell)) {
+                return std::string("carattere non valido '") + cell + "'";
+            }
+            if (cell == 'I') {
+                parsed.start_x = x;
+                parsed.start_y = y;
+            } else if (cell == 'E') {
+                parsed.end_x = x;
+                parsed.end_y = y;
+            }
+            parsed.grid_hash = (parsed.grid_hash ^ static_cast<unsigned char>(cell)) * 1099511628211ull;
+        }
+        parsed.grid_hash = (parsed.grid_hash ^ '\n') * 1099511628211ull;
+        
+        if (!parsed.grid.empty() && row.size() != parsed.grid[0].size()) {
+            return "righe della griglia di lunghezza diversa";
+        }
+        parsed.grid.push_back(std::move(row));
+    }
+    
+    if (parsed.grid.size() < 3) {
+        return "mappa troppo piccola";
+    }
+    if (parsed.start_x == -1) {
+        return "manca l'ingresso (I)";
+    }
+    if (parsed.end_x == -1) {
+        return "manca l'uscita (E)";
+    }
+    return "";
+}
+
+// Regole con cui è stata risolta una mappa: quelle del gioco (MapTerrain.simulate_move in GDScript,
+// usate da Map_gen/MapIO) o quelle di questo generatore (D uguale a G, una sola spinta per nastro)
+enum class AuditRules { GAME, GENERATOR };
+
+// Ghiaccio fragile attraversato in un cammino: indici di cella in ordine di inserimento, condivisi tra
+// gli stati come il Dictionary della versione GDScript (che non viene mai modificato dopo la creazione)
+using BrokenIce = std::shared_ptr<const std::vector<int>>;
+
+// Porting fedele di MapTerrain.simulate_move e MapPathfinding.run_dijkstra_search:
+// il ghiaccio fragile si rompe dopo essere stato attraversato, i nastri si concatenano (fino a 15 spinte)
+// e la coda è una FIFO con lo stesso ordine di visita, così min_moves/total_moves coincidono con gli
+// header scritti da MapIO. Anche gli effetti collaterali sulla mappa (ghiaccio rotto dai nastri che non
+// viene ripristinato quando si rileva un ciclo) sono riprodotti così come sono.
+class GameRulesSolver {
+public:
+    explicit GameRulesSolver(const std::vector<std::vector<char>>& game_map)
+        : map(game_map), width(static_cast<int>(game_map[0].size())), height(static_cast<int>(game_map.size())) {}
+    
+    PathResult solve(int start_x, int start_y, int end_x, int end_y, int max_moves) {
+        struct Entry {
+            int x, y, dir;
+            BrokenIce broken;
+        };
+        
+        std::vector<int> distance(width * height * 5, -1);
+        std::vector<std::array<int, 3>> parent(width * height * 5, {-1, -1, -1});
+        std::vector<Entry> queue;
+        queue.push_back({start_x, start_y, 4, std::make_shared<const std::vector<int>>()});
+        distance[stateIndex(start_x, start_y, 4)] = 0;
+        
+        bool found = false;
+        for (size_t head = 0; head < queue.size(); head++) {
+            Entry current = queue[head];
+            if (current.x == end_x && current.y == end_y) {
+                found = true;
+                break;
+            }
+            int current_distance = distance[stateIndex(current.x, current.y, current.dir)];
+            if (current_distance > max_moves) {
+                break;
+            }
+            
+            for (int i = 0; i < 4; i++) {
+                Move move = simulateMove(current.broken, current.x, current.y, DIR_DX[i], DIR_DY[i]);
+                if ((move.x == current.x && move.y == current.y) || isDeadly(move.x, move.y) ||
+                    contains(*move.broken, move.y * width + move.x)) {
+                    continue;
+                }
+                
+                int move_cost = (current.dir == 4 || current.dir != i) ? 1 : 0;
+                int new_distance = current_distance + move_cost;
+                int next = stateIndex(move.x, move.y, i);
+                if (distance[next] == -1 || distance[next] > new_distance) {
+                    distance[next] = new_distance;
+                    parent[next] = {current.x, current.y, current.dir};
+                    queue.push_back({move.x, move.y, i, move.broken});
+                }
+            }
+        }
+        
+        if (!found) {
+            return {-1, {}};
+        }
+        
+        int best_dir = -1;
+        for (int dir = 0; dir < 5; dir++) {
+            int d = distance[stateIndex(end_x, end_y, dir)];
+            if (d != -1 && (best_dir == -1 || d < distance[stateIndex(end_x, end_y, best_dir)])) {
+                best_dir = dir;
+            }
+        }
+        
+        std::vector<int> full_path;
+        int trace_x = end_x, trace_y = end_y, trace_dir = best_dir;
+        while (!(trace_x == start_x && trace_y == start_y && trace_dir == 4)) {
+            if (trace_x < 0 || full_path.size() > distance.size()) {
+                return {-1, {}};
+            }
+            full_path.push_back(trace_dir);
+            const auto& info = parent[stateIndex(trace_x, trace_y, trace_dir)];
+            trace_x = info[0];
+            trace_y = info[1];
+            trace_dir = info[2];
+        }
+        std::reverse(full_path.begin(), full_path.end());
+        return {distance[stateIndex(end_x, end_y, best_dir)], full_path};
+    }
+    
+private:
+    struct Move {
+        int x, y;
+        BrokenIce broken;
+    };
+    
+    int stateIndex(int x, int y, int dir) const { return (y * width + x) * 5 + dir; }
+    bool isValid(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+    bool isWall(int x, int y) const { return map[y][x] == 'M'; }
+    bool isIce(int x, int y) const { return map[y][x] == 'G'; }
+    bool isFragile(int x, int y) const { return map[y][x] == 'D'; }
+    bool isDeadly(int x, int y) const { return map[y][x] == 'B' || map[y][x] == 'X'; }
+    bool isStopping(int x, int y) const { return map[y][x] == 'T' || map[y][x] == 'I' || map[y][x] == 'E'; }
+    bool isConveyor(int x, int y) const { return map[y][x] >= '1' && map[y][x] <= '4'; }
+    
+    static bool contains(const std::vector<int>& cells, int cell) {
+        return std::find(cells.begin(), cells.end(), cell) != cells.end();
+    }
+    
+    void setCells(const std::vector<int>& cells, char tile) {
+        for (int cell : cells) {
+            map[cell / width][cell % width] = tile;
+        }
+    }
     
-    // Genera dimensioni casuali
-    std::mt19937 rng(std::time(nullptr));
-    int width = MIN_SIZE + (rng() % (MAX_SIZE - MIN_SIZE + 1));
-    int height = MIN_SIZE + (rng() % (MAX_SIZE - MIN_SIZE + 1));
+    Move simulateMove(const BrokenIce& broken, int x, int y, int dx, int dy) {
+        int new_x = x + dx;
+        int new_y = y + dy;
+        if (!isValid(new_x, new_y) || isWall(new_x, new_y)) {
+            return {x, y, broken};
+        }
+        
+        setCells(*broken, 'X');
+        if (isDeadly(new_x, new_y)) {
+            setCells(*broken, 'D');
+            return {new_x, new_y, broken};
+        }
+        
+        auto new_broken = std::make_shared<std::vector<int>>(*broken);
+        auto record = [&](int cell_x, int cell_y) {
+            int cell = cell_y * width + cell_x;
+            if (!contains(*new_broken, cell)) {
+                new_broken->push_back(cell);
+            }
+        };
+        if (isFragile(new_x, new_y)) {
+            record(new_x, new_y);
+        }
+        
+        int direction_x = dx, direction_y = dy;
+        std::vector<int> visited_conveyors;
+        int max_iterations = std::max(width, height) * 2;
+        
+        for (int iterations = 0; iterations < max_iterations; iterations++) {
+            bool conveyor_processed = false;
+            for (int conveyor_iterations = 0; isConveyor(new_x, new_y) && conveyor_iterations < 15; conveyor_iterations++) {
+                conveyor_processed = true;
+                
+                // Stesso nastro con la stessa direzione di ingresso: ciclo, nessun progresso
+                int key = ((new_y * width + new_x) * 3 + direction_x + 1) * 3 + direction_y + 1;
+                if (contains(visited_conveyors, key)) {
+                    setCells(*broken, 'D');
+                    return {x, y, broken};
+                }
+                visited_conveyors.push_back(key);
+                
+                int dir = map[new_y][new_x] - '1';
+                int pushed_x = new_x + DIR_DX[dir];
+                int pushed_y = new_y + DIR_DY[dir];
+                if (!isValid(pushed_x, pushed_y) || isWall(pushed_x, pushed_y)) {
+                    break;
+                }
+                if (isDeadly(pushed_x, pushed_y)) {
+                    setCells(*new_broken, 'D');
+                    return {pushed_x, pushed_y, new_broken};
+                }
+                
+                new_x = pushed_x;
+                new_y = pushed_y;
+                direction_x = DIR_DX[dir];
+                direction_y = DIR_DY[dir];
+                
+                if (isFragile(new_x, new_y)) {
+                    map[new_y][new_x] = 'X';
+                    record(new_x, new_y);
+                }
+                if (isStopping(new_x, new_y)) {
+                    break;
+                }
+            }
+            
+            if (isStopping(new_x, new_y) || isDeadly(new_x, new_y)) {
+                break;
+            }
+            
+            bool on_ice = isIce(new_x, new_y) || isFragile(new_x, new_y);
+            if (!on_ice && !conveyor_processed) {
+                break;
+            }
+            
+            if (on_ice) {
+                int next_x = new_x + direction_x;
+                int next_y = new_y + direction_y;
+                if (!isValid(next_x, next_y) || isWall(next_x, next_y)) {
+                    break;
+                }
+                new_x = next_x;
+                new_y = next_y;
+                if (isFragile(new_x, new_y)) {
+                    record(new_x, new_y);
+                }
+            }
+        }
+        
+        for (int cell : *new_broken) {
+            if (map[cell / width][cell % width] == 'D') {
+                map[cell / width][cell % width] = 'X';
+            }
+        }
+        setCells(*new_broken, 'D');
+        return {new_x, new_y, new_broken};
+    }
     
     std::vector<std::vector<char>> map;
-    int start_x, start_y, end_x, end_y;
-    int count = 0;
-    PathResult result = {0, {}};
+    int width;
+    int height;
+};
+
+// Limite di mosse usato dal gioco quando risolve una mappa esistente (Map_gen.test_map)
+constexpr int GAME_AUDIT_MAX_MOVES = 999;
+
+// Esito della verifica di un singolo file
+struct AuditEntry {
+    std::string path;
+    std::string error;          // Vuoto se il file è stato letto correttamente
+    int header_min_moves = -1;
+    int header_total_moves = -1;
+    int min_moves = -1;
+    int total_moves = -1;
+    int width = 0;
+    int height = 0;
+    uint64_t grid_hash = 0;
+};
+
+// Legge, analizza e risolve di nuovo un file .map
+void auditMapFile(AuditEntry& entry, AuditRules rules) {
+    MappedFile file(entry.path);
+    if (!file.isOpen()) {
+        entry.error = "impossibile aprire il file";
+        return;
+    }
     
-    // Genera mappe finché non ne trovi una valida e sufficientemente difficile
-    do {
-        count++;
+    ParsedMap parsed;
+    entry.error = parseMapBuffer(file.data(), file.size(), parsed);
+    if (!entry.error.empty()) {
+        return;
+    }
+    
+    entry.header_min_moves = parsed.min_moves;
+    entry.header_total_moves = parsed.total_moves;
+    entry.width = static_cast<int>(parsed.grid[0].size());
+    entry.height = static_cast<int>(parsed.grid.size());
+    entry.grid_hash = parsed.grid_hash;
+    
+    PathResult result;
+    if (rules == AuditRules::GAME) {
+        result = GameRulesSolver(parsed.grid).solve(parsed.start_x, parsed.start_y, parsed.end_x, parsed.end_y,
+                                                    GAME_AUDIT_MAX_MOVES);
+    } else {
+        result = calculateMinMovesAndPathFor(detectFeatures(parsed.grid), parsed.grid,
+                                             parsed.start_x, parsed.start_y, parsed.end_x, parsed.end_y);
+    }
+    entry.min_moves = result.min_moves;
+    entry.total_moves = result.min_moves == -1 ? -1 : static_cast<int>(result.full_path.size());
+}
+
+// Verifica in parallelo tutti i file .map di una cartella (ricorsivamente) e stampa un report:
+// file non validi, mappe irrisolvibili, header min_moves/total_moves errati e duplicati.
+// Le mappe vengono risolte di nuovo con le regole indicate: quelle del gioco per i file scritti da
+// Map_gen/MapIO, quelle del generatore per i file prodotti da questo programma.
+// Restituisce 0 se il corpus è pulito, 2 se sono stati trovati problemi.
+int runAudit(const std::string& directory, unsigned thread_count, AuditRules rules) {
+    std::error_code error;
+    if (!std::filesystem::is_directory(directory, error)) {
+        std::cerr << "Errore: " << directory << " non e una cartella." << std::endl;
+        return 1;
+    }
+    
+    std::vector<AuditEntry> entries;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (error) {
+            break;
+        }
+        if (it->is_regular_file(error) && it->path().extension() == ".map") {
+            AuditEntry entry;
+            entry.path = it->path().string();
+            entries.push_back(std::move(entry));
+        }
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const AuditEntry& a, const AuditEntry& b) { return a.path < b.path; });
+    
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::cout << "Verifica di " << entries.size() << " mappe in " << directory
+              << " con " << thread_count << " thread, regole del "
+              << (rules == AuditRules::GAME ? "gioco" : "generatore") << "..." << std::endl;
+    
+    // Ogni thread prende il prossimo file libero: nessun lock sul percorso critico
+    std::atomic<size_t> next_entry{0};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < thread_count; t++) {
+        workers.emplace_back([&entries, &next_entry, rules]() {
+            for (size_t i = next_entry++; i < entries.size(); i = next_entry++) {
+                auditMapFile(entries[i], rules);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    int invalid = 0, unsolvable = 0, mismatched = 0, duplicates = 0;
+    std::unordered_map<uint64_t, size_t> first_by_hash;
+    
+    for (size_t i = 0; i < entries.size(); i++) {
+        const AuditEntry& entry = entries[i];
         
-        // Controllo limite tentativi
-        if (count > MAX_ATTEMPTS) {
-            std::cerr << "Errore: impossibile generare una mappa valida dopo " << MAX_ATTEMPTS << " tentativi." << std::endl;
-            std::cerr << "Prova a ridurre la difficolta o modificare i parametri." << std::endl;
-            exit(-104);
+        if (!entry.error.empty()) {
+            invalid++;
+            std::cout << "NON VALIDA    " << entry.path << ": " << entry.error << std::endl;
+            continue;
         }
         
-        // Genera una nuova mappa
-        map = generateSingleMap(rng, width, height, difficulty, start_x, start_y, end_x, end_y);
+        if (entry.min_moves == -1) {
+            unsolvable++;
+            std::cout << "IRRISOLVIBILE " << entry.path << std::endl;
+        } else if (entry.header_min_moves != entry.min_moves || entry.header_total_moves != entry.total_moves) {
+            mismatched++;
+            std::cout << "MOSSE ERRATE  " << entry.path
+                      << ": header min_moves=" << entry.header_min_moves << " total_moves=" << entry.header_total_moves
+                      << ", calcolate min_moves=" << entry.min_moves << " total_moves=" << entry.total_moves << std::endl;
+        }
+        
+        auto [it, inserted] = first_by_hash.emplace(entry.grid_hash, i);
+        if (!inserted) {
+            const AuditEntry& first = entries[it->second];
+            if (first.width == entry.width && first.height == entry.height) {
+                duplicates++;
+                std::cout << "DUPLICATA     " << entry.path << " = " << first.path << std::endl;
+            }
+        }
+    }
+    
+    std::cout << "Mappe verificate: " << entries.size()
+              << ", non valide: " << invalid
+              << ", irrisolvibili: " << unsolvable
+              << ", mosse errate: " << mismatched
+              << ", duplicate: " << duplicates << std::endl;
+    
+    return (invalid + unsolvable + mismatched + duplicates) > 0 ? 2 : 0;
+}
+
+// Limite al numero di thread richiesto da riga di comando
+constexpr int MAX_THREADS = 256;
+
+// Interpreta --threads: 0 = tutti i core; valori negativi o oltre MAX_THREADS lanciano std::invalid_argument
+unsigned parseThreadCount(const std::string& value) {
+    int count = std::stoi(value);
+    if (count < 0 || count > MAX_THREADS) {
+        throw std::invalid_argument(value);
+    }
+    return static_cast<unsigned>(count);
+}
+
+// Parametri della generazione massiva (modalità batch)
+struct BatchParams {
+    std::string directory;
+    long long count = 0;                        // Mappe totali, sommate su tutti gli shard
+    std::vector<std::pair<int, int>> difficulty_mix = {{1, 1}, {2, 1}, {3, 1}, {4, 1}, {5, 1}};  // (difficoltà, peso)
+    int shard_index = 0;
+    int shard_count = 1;
+    unsigned thread_count = 0;                  // 0 = tutti i core
+    uint64_t seed = 0;                          // Seme base: deve essere lo stesso su tutte le macchine
+    int chunk_size = 256;                       // Mappe per blocco (unità di checkpoint)
+    long long max_file_bytes = 1024LL << 20;    // Oltre questa dimensione si passa al file successivo
+    AcceptanceFilters filters;
+    PlacementConstraints placement;
+};
+
+// Versione delle regole di generazione, scritta nella firma del checkpoint: va incrementata a ogni modifica
+// che cambia le mappe prodotte da un seme, così un batch non mescola mappe di regole diverse nello stesso shard
+constexpr int GENERATOR_VERSION = 2;
+
+// Blocco di mappe generato da un thread e scritto con un'unica append
+struct BatchChunk {
+    long long id = 0;
+    std::string data;
+    int maps = 0;
+    int failed = 0;     // Indici per cui nessun tentativo ha prodotto una mappa
+};
+
+// Generazioni complete tentate per lo stesso indice prima di rinunciare
+constexpr int BATCH_MAX_RETRIES = 8;
+
+// Mescolatore splitmix64: semi indipendenti a partire dall'indice globale della mappa
+uint64_t splitMix64(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+// Difficoltà della mappa di indice dato, estratta secondo i pesi del mix
+int batchDifficulty(const BatchParams& params, long long index, int total_weight) {
+    uint64_t draw = splitMix64(params.seed ^ splitMix64(static_cast<uint64_t>(index) * 2 + 1)) % total_weight;
+    for (const auto& [difficulty, weight] : params.difficulty_mix) {
+        if (draw < static_cast<uint64_t>(weight)) {
+            return difficulty;
+        }
+        draw -= weight;
+    }
+    return params.difficulty_mix.back().first;
+}
+
+// Genera tutte le mappe di un blocco. Seme e difficoltà dipendono solo da seme base e indice globale,
+// quindi un blocco rigenerato dopo un'interruzione è identico byte per byte.
+void generateBatchChunk(const BatchParams& params, int total_weight, BatchChunk& chunk) {
+    std::ostringstream out;
+    MapGenerator generator;
+    
+    long long first = chunk.id * params.chunk_size;
+    long long last = std::min(params.count, first + params.chunk_size);
+    
+    for (long long index = first; index < last; index++) {
+        GenerationParams generation;
+        generation.difficulty = batchDifficulty(params, index, total_weight);
+        generation.filters = params.filters;
+        generation.placement = params.placement;
+        uint64_t map_seed = splitMix64(params.seed ^ splitMix64(static_cast<uint64_t>(index) * 2));
         
-        // Verifica che esista un percorso valido
-        if (hasValidPath(map, start_x, start_y, end_x, end_y)) {
-            result = calculateMinMovesAndPath(map, start_x, start_y, end_x, end_y);
+        GenerationStatus status = GenerationStatus::FAILED;
+        for (int retry = 0; retry < BATCH_MAX_RETRIES && status != GenerationStatus::DONE; retry++) {
+            generation.seed = splitMix64(map_seed + retry);
+            generator.begin(generation);
+            while ((status = generator.step(1000000)) == GenerationStatus::PENDING) {
+            }
+        }
+        
+        if (status != GenerationStatus::DONE) {
+            chunk.failed++;
+            continue;
+        }
+        
+        // Ogni record è un file .map completo preceduto da map_index/seed (chiavi ignorate dal parser dei .map)
+        const GenerationResult& result = generator.result();
+        out << "map_index=" << index << '\n';
+        out << "seed=" << generation.seed << '\n';
+        writeMapHeader(out, result.difficulty, result.path, result.stats, result.width, result.height);
+        writeMapGrid(out, result.map);
+        out << '\n';
+        chunk.maps++;
+    }
+    
+    chunk.data = out.str();
+}
+
+// Output di uno shard: pochi file grandi a rotazione più un file di checkpoint.
+// Ogni blocco viene prima accodato all'output e poi registrato nel checkpoint con la posizione raggiunta;
+// alla ripresa l'output viene troncato all'ultima posizione registrata, così un blocco interrotto
+// a metà non lascia record parziali né duplicati.
+class BatchShardWriter {
+public:
+    // Legge il checkpoint (se esiste), segna i blocchi già completati e riapre l'output.
+    // Restituisce un messaggio di errore, vuoto se tutto è andato a buon fine.
+    std::string open(const BatchParams& params, const std::string& signature, std::vector<char>& completed) {
+        prefix = params.directory + "/shard_" + std::to_string(params.shard_index) + "_of_" + std::to_string(params.shard_count);
+        max_file_bytes = params.max_file_bytes;
+        std::string checkpoint_path = prefix + ".checkpoint";
+        
+        std::error_code error;
+        // Un checkpoint vuoto (lasciato da versioni precedenti) equivale a nessun checkpoint
+        if (std::filesystem::exists(checkpoint_path, error) && std::filesystem::file_size(checkpoint_path, error) > 0) {
+            std::ifstream existing(checkpoint_path, std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(existing)), std::istreambuf_iterator<char>());
+            existing.close();
+            
+            size_t line_end = content.find('\n');
+            if (line_end == std::string::npos || content.compare(0, line_end, signature) != 0) {
+                return "il checkpoint " + checkpoint_path + " appartiene a un'altra configurazione";
+            }
+            
+            // Solo le righe complete contano: un'ultima riga troncata viene scartata
+            size_t valid_bytes = line_end + 1;
+            while ((line_end = content.find('\n', valid_bytes)) != std::string::npos) {
+                std::istringstream line(content.substr(valid_bytes, line_end - valid_bytes));
+                std::string chunk_key, part_key, offset_key, maps_key, failed_key;
+                long long chunk_id, offset;
+                int part, maps, failed;
+                if (!(line >> chunk_key >> chunk_id >> part_key >> part >> offset_key >> offset
+                           >> maps_key >> maps >> failed_key >> failed) ||
+                    chunk_id < 0 || chunk_id >= static_cast<long long>(completed.size())) {
+                    break;
+                }
+                completed[chunk_id] = 1;
+                current_part = part;
+                current_offset = offset;
+                maps_written += maps;
+                maps_failed += failed;
+                valid_bytes = line_end + 1;
+            }
+            std::filesystem::resize_file(checkpoint_path, valid_bytes, error);
         } else {
-            result = {-1, {}};
+            // La firma viene scritta in un file temporaneo e poi rinominata: un'interruzione qui
+            // non lascia mai un checkpoint vuoto o senza firma
+            std::string temporary_path = checkpoint_path + ".tmp";
+            std::ofstream created(temporary_path, std::ios::binary | std::ios::trunc);
+            created << signature << '\n';
+            created.close();
+            if (created.fail()) {
+                return "impossibile creare " + temporary_path;
+            }
+            std::filesystem::rename(temporary_path, checkpoint_path, error);
+            if (error) {
+                return "impossibile creare " + checkpoint_path;
+            }
         }
-        // Mostra progresso ogni 100 tentativi
-        if (count % 100 == 0) {
-            std::cout << "Tentativo " << count << "/1000..." << std::endl;
+        
+        // Scarta tutto ciò che è stato scritto dopo l'ultimo blocco registrato
+        std::string current_path = partPath(current_part);
+        if (std::filesystem::exists(current_path, error)) {
+            if (std::filesystem::file_size(current_path, error) < static_cast<uintmax_t>(current_offset)) {
+                return "il file " + current_path + " è più corto di quanto registrato nel checkpoint";
+            }
+            std::filesystem::resize_file(current_path, current_offset, error);
+        } else if (current_offset > 0) {
+            return "manca il file " + current_path + " registrato nel checkpoint";
+        }
+        for (int part = current_part + 1; std::filesystem::remove(partPath(part), error); part++) {
         }
         
-    } while (result.min_moves < MIN_MOVES || result.min_moves == -1);
+        output.open(current_path, std::ios::binary | std::ios::app);
+        checkpoint.open(checkpoint_path, std::ios::binary | std::ios::app);
+        if (!output.is_open() || !checkpoint.is_open()) {
+            return "impossibile aprire i file di output in " + params.directory;
+        }
+        return "";
+    }
     
-    // Stampa informazioni e scrivi file
-    printMapInfo(count, result);
-    writeMapHeader(file, difficulty, result, width, height);
-    writeMapGrid(file, map);
+    // Accoda un blocco e lo registra nel checkpoint; da chiamare con il lock dell'output
+    bool append(const BatchChunk& chunk) {
+        if (current_offset >= max_file_bytes) {
+            output.close();
+            current_part++;
+            current_offset = 0;
+            output.open(partPath(current_part), std::ios::binary | std::ios::trunc);
+        }
+        
+        output.write(chunk.data.data(), static_cast<std::streamsize>(chunk.data.size()));
+        output.flush();
+        if (!output.good()) {
+            return false;
+        }
+        current_offset += static_cast<long long>(chunk.data.size());
+        maps_written += chunk.maps;
+        maps_failed += chunk.failed;
+        
+        checkpoint << "chunk " << chunk.id << " part " << current_part << " offset " << current_offset
+                   << " maps " << chunk.maps << " failed " << chunk.failed << '\n';
+        checkpoint.flush();
+        return checkpoint.good();
+    }
+    
+    long long mapsWritten() const { return maps_written; }
+    long long mapsFailed() const { return maps_failed; }
+    int partsUsed() const { return current_part + 1; }
+    
+private:
+    std::string partPath(int part) const {
+        std::string number = std::to_string(part);
+        return prefix + "_part" + std::string(number.size() < 4 ? 4 - number.size() : 0, '0') + number + ".maps";
+    }
+    
+    std::string prefix;
+    long long max_file_bytes = 0;
+    std::ofstream output;
+    std::ofstream checkpoint;
+    int current_part = 0;
+    long long current_offset = 0;
+    long long maps_written = 0;
+    long long maps_failed = 0;
+};
+
+// Genera la parte di un batch assegnata a questo shard usando tutti i thread.
+// I blocchi sono assegnati agli shard a turno (blocco % shard_count == shard_index), quindi
+// macchine diverse con lo stesso seme base producono insiemi disgiunti e riproducibili.
+int runBatch(const BatchParams& params) {
+    std::error_code error;
+    std::filesystem::create_directories(params.directory, error);
+    if (!std::filesystem::is_directory(params.directory, error)) {
+        std::cerr << "Errore: impossibile creare la cartella " << params.directory << std::endl;
+        return 1;
+    }
+    
+    int total_weight = 0;
+    for (const auto& entry : params.difficulty_mix) {
+        total_weight += entry.second;
+    }
+    long long total_chunks = (params.count + params.chunk_size - 1) / params.chunk_size;
+    
+    // La firma lega il checkpoint ai parametri che determinano il contenuto delle mappe.
+    // 17 cifre significative identificano un double in modo univoco: valori diversi danno firme diverse.
+    std::ostringstream signature;
+    signature << std::setprecision(17);
+    signature << "# batch version=" << GENERATOR_VERSION << " count=" << params.count << " mix=";
+    for (size_t i = 0; i < params.difficulty_mix.size(); i++) {
+        signature << (i > 0 ? "," : "") << params.difficulty_mix[i].first << ":" << params.difficulty_mix[i].second;
+    }
+    signature << " shard=" << params.shard_index << "/" << params.shard_count
+              << " seed=" << params.seed << " chunk=" << params.chunk_size
+              << " max_trap_ratio=" << params.filters.max_trap_ratio
+              << " min_branching=" << params.filters.min_branching
+              << " max_cycle=" << params.filters.max_cycle
+              << " hole_min_distance=" << params.placement.hole_min_distance
+              << " max_wall_cluster=" << params.placement.max_wall_cluster
+              << " region_size=" << params.placement.region_size
+              << " region_slack=" << params.placement.region_density_slack;
+    
+    std::vector<char> completed(total_chunks, 0);
+    BatchShardWriter writer;
+    std::string open_error = writer.open(params, signature.str(), completed);
+    if (!open_error.empty()) {
+        std::cerr << "Errore: " << open_error << std::endl;
+        return 1;
+    }
+    
+    std::vector<long long> pending;
+    long long already_done = 0;
+    for (long long chunk = params.shard_index; chunk < total_chunks; chunk += params.shard_count) {
+        if (completed[chunk]) {
+            already_done++;
+        } else {
+            pending.push_back(chunk);
+        }
+    }
+    
+    unsigned thread_count = params.thread_count;
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::cout << "Shard " << params.shard_index << "/" << params.shard_count << ": "
+              << pending.size() << " blocchi da generare, " << already_done << " gia completati, "
+              << thread_count << " thread" << std::endl;
+    
+    // I thread generano blocchi interi in memoria; solo la scrittura avviene sotto lock
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<bool> write_failed{false};
+    std::mutex output_mutex;
+    size_t chunks_written = 0;
+    long long maps_at_start = writer.mapsWritten();
+    auto started = std::chrono::steady_clock::now();
+    auto last_report = started;
+    
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < thread_count; t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = next_chunk++; i < pending.size() && !write_failed; i = next_chunk++) {
+                BatchChunk chunk;
+                chunk.id = pending[i];
+                generateBatchChunk(params, total_weight, chunk);
+                
+                std::lock_guard<std::mutex> lock(output_mutex);
+                if (!writer.append(chunk)) {
+                    write_failed = true;
+                    break;
+                }
+                chunks_written++;
+                
+                // Avanzamento al massimo una volta ogni 5 secondi
+                auto now = std::chrono::steady_clock::now();
+                if (now - last_report >= std::chrono::seconds(5) || chunks_written == pending.size()) {
+                    last_report = now;
+                    double seconds = std::chrono::duration<double>(now - started).count();
+                    std::cout << "Blocchi " << chunks_written << "/" << pending.size()
+                              << ", mappe scritte: " << writer.mapsWritten()
+                              << " (" << static_cast<long long>((writer.mapsWritten() - maps_at_start) / seconds)
+                              << " mappe/s)" << std::endl;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    if (write_failed) {
+        std::cerr << "Errore: scrittura fallita in " << params.directory
+                  << ", rilanciare lo stesso comando per riprendere." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Shard completato: " << writer.mapsWritten() << " mappe in " << writer.partsUsed()
+              << " file, " << writer.mapsFailed() << " indici senza mappa valida." << std::endl;
+    return 0;
+}
+
+// Interpreta un filtro di accettazione; false se l'opzione non è un filtro (valori non validi lanciano eccezioni)
+bool parseFilterOption(const std::string& option, const std::string& value, AcceptanceFilters& filters) {
+    if (option == "--max-trap-ratio") {
+        filters.max_trap_ratio = std::stod(value);
+        if (!(filters.max_trap_ratio >= 0.0 && filters.max_trap_ratio <= 1.0)) {
+            throw std::invalid_argument(value);
+        }
+    } else if (option == "--min-branching") {
+        filters.min_branching = std::stod(value);
+        if (!(filters.min_branching >= 0.0) || std::isinf(filters.min_branching)) {
+            throw std::invalid_argument(value);
+        }
+    } else if (option == "--max-cycle") {
+        filters.max_cycle = std::stoi(value);
+        if (filters.max_cycle < -1) {
+            throw std::invalid_argument(value);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Interpreta un vincolo di piazzamento; false se l'opzione non è un vincolo (valori non validi lanciano eccezioni)
+bool parsePlacementOption(const std::string& option, const std::string& value, PlacementConstraints& placement) {
+    if (option == "--hole-min-distance") {
+        placement.hole_min_distance = std::stoi(value);
+        if (placement.hole_min_distance < 1) {
+            throw std::invalid_argument(value);
+        }
+    } else if (option == "--max-wall-cluster") {
+        placement.max_wall_cluster = std::stoi(value);
+        if (placement.max_wall_cluster < -1 || placement.max_wall_cluster == 0) {
+            throw std::invalid_argument(value);
+        }
+    } else if (option == "--region-size") {
+        placement.region_size = std::stoi(value);
+        if (placement.region_size < 0) {
+            throw std::invalid_argument(value);
+        }
+    } else if (option == "--region-slack") {
+        placement.region_density_slack = std::stod(value);
+        if (!(placement.region_density_slack > 0.0)) {
+            throw std::invalid_argument(value);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Interpreta le opzioni della modalità batch; stampa l'errore e restituisce false se non sono valide
+bool parseBatchArguments(int argc, char* argv[], BatchParams& params) {
+    params.directory = argv[2];
+    
+    for (int i = 3; i < argc; i += 2) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Errore: manca il valore per " << option << std::endl;
+            return false;
+        }
+        std::string value = argv[i + 1];
+        
+        try {
+            if (option == "--count") {
+                params.count = std::stoll(value);
+            } else if (option == "--difficulty-mix") {
+                params.difficulty_mix.clear();
+                std::istringstream entries(value);
+                std::string entry;
+                while (std::getline(entries, entry, ',')) {
+                    size_t colon = entry.find(':');
+                    if (colon == std::string::npos) {
+                        throw std::invalid_argument(entry);
+                    }
+                    int difficulty = std::stoi(entry.substr(0, colon));
+                    int weight = std::stoi(entry.substr(colon + 1));
+                    if (difficulty < 1 || difficulty > 5 || weight <= 0) {
+                        throw std::invalid_argument(entry);
+                    }
+                    params.difficulty_mix.emplace_back(difficulty, weight);
+                }
+                if (params.difficulty_mix.empty()) {
+                    throw std::invalid_argument(value);
+                }
+            } else if (option == "--shard") {
+                size_t slash = value.find('/');
+                if (slash == std::string::npos) {
+                    throw std::invalid_argument(value);
+                }
+                params.shard_index = std::stoi(value.substr(0, slash));
+                params.shard_count = std::stoi(value.substr(slash + 1));
+                if (params.shard_count < 1 || params.shard_index < 0 || params.shard_index >= params.shard_count) {
+                    throw std::invalid_argument(value);
+                }
+            } else if (option == "--threads") {
+                params.thread_count = parseThreadCount(value);
+            } else if (option == "--seed") {
+                params.seed = std::stoull(value);
+            } else if (option == "--chunk-size") {
+                params.chunk_size = std::stoi(value);
+                if (params.chunk_size < 1) {
+                    throw std::invalid_argument(value);
+                }
+            } else if (option == "--max-file-mb") {
+                long long megabytes = std::stoll(value);
+                if (megabytes < 1 || megabytes > (std::numeric_limits<long long>::max() >> 20)) {
+                    throw std::invalid_argument(value);
+                }
+                params.max_file_bytes = megabytes << 20;
+            } else if (!parseFilterOption(option, value, params.filters) &&
+                       !parsePlacementOption(option, value, params.placement)) {
+                std::cerr << "Errore: opzione sconosciuta " << option << std::endl;
+                return false;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Errore: valore non valido per " << option << std::endl;
+            return false;
+        }
+    }
+    
+    if (params.count < 1) {
+        std::cerr << "Errore: --count e obbligatorio e deve essere positivo." << std::endl;
+        return false;
+    }
+    return true;
 }
 
 int main(int argc, char* argv[]) {
     // Controllo parametri
-    if (argc != 3) {
-        std::cerr << "Uso: " << argv[0] << " <nome_file> <livello_difficolta>" << std::endl;
+    if (argc < 3) {
+        std::cerr << "Uso: " << argv[0] << " <nome_file> <livello_difficolta> [filtri]" << std::endl;
         std::cerr << "Esempio: " << argv[0] << " mappa1 2" << std::endl;
         std::cerr << "Difficolta: 1-5 (1=facile, 5=molto difficile)" << std::endl;
+        std::cerr << "Filtri opzionali: --max-trap-ratio <0-1> --min-branching <n> --max-cycle <stati>" << std::endl;
+        std::cerr << "Vincoli opzionali: --hole-min-distance <n> --max-wall-cluster <celle> --region-size <lato>"
+                  << " --region-slack <x>" << std::endl;
+        std::cerr << "Verifica corpus: " << argv[0] << " audit <cartella> [--threads <n>] [--rules gioco|generatore]" << std::endl;
+        std::cerr << "Generazione massiva: " << argv[0] << " batch <cartella> --count <n> [--difficulty-mix 1:20,5:80]"
+                  << " [--shard <i>/<k>] [--seed <n>] [--threads <n>] [--chunk-size <n>] [--max-file-mb <n>] [filtri] [vincoli]" << std::endl;
         return 1;
     }
     
+    // Modalità di generazione massiva, riprendibile dal checkpoint della cartella di output
+    if (std::string(argv[1]) == "batch") {
+        BatchParams params;
+        if (!parseBatchArguments(argc, argv, params)) {
+            return 1;
+        }
+        return runBatch(params);
+    }
+    
+    // Modalità di verifica di un corpus di mappe esistenti
+    if (std::string(argv[1]) == "audit") {
+        unsigned thread_count = 0;
+        AuditRules rules = AuditRules::GAME;
+        for (int i = 3; i < argc; i += 2) {
+            std::string option = argv[i];
+            std::string value = i + 1 < argc ? argv[i + 1] : "";
+            if (option == "--threads" && i + 1 < argc) {
+                try {
+                    thread_count = parseThreadCount(value);
+                } catch (const std::exception& e) {
+                    std::cerr << "Errore: numero di thread non valido." << std::endl;
+                    return 1;
+                }
+            } else if (option == "--rules" && (value == "gioco" || value == "generatore")) {
+                rules = value == "gioco" ? AuditRules::GAME : AuditRules::GENERATOR;
+            } else {
+                std::cerr << "Uso: " << argv[0] << " audit <cartella> [--threads <n>] [--rules gioco|generatore]" << std::endl;
+                return 1;
+            }
+        }
+        return runAudit(argv[2], thread_count, rules);
+    }
+    
     std::string filename = argv[1];
     int difficulty_level;
     
@@ -764,6 +2702,27 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Filtri di accettazione opzionali sul grafo degli stati e vincoli di piazzamento
+    AcceptanceFilters filters;
+    PlacementConstraints placement;
+    for (int i = 3; i < argc; i += 2) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Errore: manca il valore per " << option << std::endl;
+            return 1;
+        }
+        try {
+            if (!parseFilterOption(option, argv[i + 1], filters) &&
+                !parsePlacementOption(option, argv[i + 1], placement)) {
+                std::cerr << "Errore: opzione sconosciuta " << option << std::endl;
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Errore: valore non valido per " << option << std::endl;
+            return 1;
+        }
+    }
+    
     // Aggiungi estensione .map se non presente
     if (filename.find(".map") == std::string::npos) {
         filename += ".map";
@@ -779,7 +2738,7 @@ int main(int argc, char* argv[]) {
     
     std::cout << "Generando mappa: " << filename << " con difficolta: " << difficulty_level << std::endl;
     
-    generateMap(mapFile, difficulty_level);
+    generateMap(mapFile, difficulty_level, filters, placement);
     
     mapFile.close();
     std::cout << "Mappa generata con successo!" << std::endl;
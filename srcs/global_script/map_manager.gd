@@ -383,6 +383,9 @@ func _test_thread_capability(test_thread: Thread) -> bool:
 func _generate_map_direct(map_name: String, difficulty: String) -> int:
 	"""
 	Generate a map directly without threading (browser-safe).
+	Each call gets its own Map_gen.Generation, stepped in slices of
+	Map_gen.FRAME_BUDGET_USEC (one per frame), so the loading screen keeps
+	rendering and concurrent generations do not share state.
 	
 	Args:
 		map_name: Name for the generated map
@@ -395,7 +398,13 @@ func _generate_map_direct(map_name: String, difficulty: String) -> int:
 	var success = false
 	
 	for attempt in range(MAX_ATTEMPTS):
-		var exit_code = await map_generator.generate_map(map_name, difficulty)
+		var exit_code = -1
+		var generation = map_generator.begin(difficulty)
+		
+		if generation != null:
+			while generation.step(Map_gen.FRAME_BUDGET_USEC) == Map_gen.GenerationStatus.PENDING:
+				await get_tree().process_frame
+			exit_code = map_generator.save_result(generation, map_name)
 		
 		if exit_code == 0:
 			var generated_map_path = "user://maps/" + map_name + ".map"
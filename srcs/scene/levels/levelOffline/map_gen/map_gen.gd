@@ -1,29 +1,112 @@
 class_name Map_gen
 extends Node
 
-# Parametri di difficoltà
-var min_moves: int
-var max_moves: int
+enum GenerationStatus { PENDING, DONE, FAILED, CANCELLED }
 
-# Funzione principale di generazione
+# Tempo massimo per frame della generazione senza thread (build web): lascia spazio al rendering
+const FRAME_BUDGET_USEC = 8000
+# Unità di lavoro (righe allocate, passi di costruzione, stati espansi) tra due controlli dell'orologio
+const SLICE_UNITS = 32
+
+# Una generazione a fette. Tutto il suo stato resta in questo oggetto tra una chiamata e l'altra,
+# così più generazioni contemporanee (mappa di riserva, schermata di caricamento, thread) non si disturbano.
+class Generation:
+	extends RefCounted
+	
+	var config: Dictionary
+	var width: int
+	var height: int
+	var attempts: int = 0
+	var positions: Array = [0, 0, 0, 0]
+	var map: Array = []
+	var build_step: int = -1  # Passo di costruzione della mappa corrente (-1 = nessuna mappa in costruzione)
+	var search: MapPathfinding.DijkstraSearch = null
+	var status: Map_gen.GenerationStatus = Map_gen.GenerationStatus.PENDING
+	var cancel_requested: bool = false
+	var map_data: Dictionary = {}
+	
+	func _init(generation_config: Dictionary):
+		config = generation_config
+		width = config.min_size + (randi() % (config.max_size - config.min_size + 1))
+		height = config.min_size + (randi() % (config.max_size - config.min_size + 1))
+	
+	func step(budget_usec: int) -> Map_gen.GenerationStatus:
+		"""
+		Work for about budget_usec microseconds (at least one unit) and return the current status.
+		"""
+		var deadline = Time.get_ticks_usec() + budget_usec
+		
+		while status == Map_gen.GenerationStatus.PENDING:
+			if cancel_requested:
+				status = Map_gen.GenerationStatus.CANCELLED
+				break
+			
+			if search != null:
+				if search.advance(Map_gen.SLICE_UNITS):
+					_finish_attempt()
+			elif build_step >= 0:
+				_build_next()
+			else:
+				if attempts >= config.max_attempts:
+					GlobalVariables.d_error("Errore: impossibile generare una mappa valida dopo " + str(config.max_attempts) + " tentativi.", "MAP_GENERATION")
+					status = Map_gen.GenerationStatus.FAILED
+					break
+				attempts += 1
+				
+				if attempts % 100 == 0:
+					GlobalVariables.d_debug("Tentativo " + str(attempts) + "/" + str(config.max_attempts) + "...", "MAP_GENERATION")
+				
+				map = []
+				build_step = 0
+			
+			if Time.get_ticks_usec() >= deadline:
+				break
+		
+		return status
+	
+	func cancel():
+		"""Stop this generation at the next step()"""
+		cancel_requested = true
+	
+	func get_progress() -> float:
+		"""Attempts used against the maximum (upper bound of the remaining work)"""
+		return float(attempts) / config.max_attempts
+	
+	# Costruisce la mappa un pezzo alla volta: prima le righe vuote, poi un passo di terreno per unità
+	func _build_next():
+		if map.size() < height:
+			map.append(MapGeneration.create_empty_row(width, height, map.size()))
+		elif build_step < MapGeneration.BUILD_STEPS:
+			MapGeneration.run_build_step(map, config.difficulty, positions, build_step)
+			build_step += 1
+		else:
+			build_step = -1
+			search = MapPathfinding.DijkstraSearch.new(map, positions[0], positions[1], positions[2], positions[3], config.max_moves)
+	
+	func _finish_attempt():
+		var result = MapPathfinding.build_path_result(search.get_result(), map, positions[0], positions[1], positions[2], positions[3])
+		search = null
+		
+		if result.min_moves != -1 and result.min_moves >= config.min_moves and result.min_moves <= config.max_moves:
+			map_data = {
+				"map": map,
+				"result": result,
+				"width": width,
+				"height": height,
+				"attempts": attempts
+			}
+			status = Map_gen.GenerationStatus.DONE
+
+# Funzione principale di generazione: a fette di FRAME_BUDGET_USEC, un frame alla volta
 func generate_map(map_name: String, difficulty: String) -> int:
-	var difficulty_level = difficulty.to_int()
-	
-	if not _is_valid_difficulty(difficulty_level):
-		GlobalVariables.d_error("Errore: la difficoltà deve essere tra 1 e 5.", "MAP_GENERATION")
+	var generation = begin(difficulty)
+	if generation == null:
 		return -1
 	
-	var config = _get_difficulty_config(difficulty_level)
-	var map_data = await _generate_valid_map(config)
-	
-	if map_data.error_code != 0:
-		return map_data.error_code
-	
-	# Salva la mappa
-	MapIO.save_map_to_file(map_name, map_data.map, difficulty_level, map_data.result, map_data.width, map_data.height)
+	while generation.step(FRAME_BUDGET_USEC) == GenerationStatus.PENDING:
+		await Engine.get_main_loop().process_frame
 	
-	_print_generation_success(map_data.attempts, map_data.result.min_moves)
-	return 0
+	return save_result(generation, map_name)
 
 func generate_map_sync(map_name: String, difficulty: String) -> int:
 	"""
@@ -36,22 +119,47 @@ func generate_map_sync(map_name: String, difficulty: String) -> int:
 	Returns:
 		0 on success, negative on failure
 	"""
+	var generation = begin(difficulty)
+	if generation == null:
+		return -1
+	
+	while generation.step(1000000) == GenerationStatus.PENDING:
+		pass
+	
+	return save_result(generation, map_name)
+
+func begin(difficulty: String) -> Generation:
+	"""
+	Start a resumable generation; drive the returned object with step() until it stops returning PENDING.
+	
+	Args:
+		difficulty: Difficulty level
+		
+	Returns:
+		The new generation, or null for an invalid difficulty
+	"""
 	var difficulty_level = difficulty.to_int()
 	
 	if not _is_valid_difficulty(difficulty_level):
 		GlobalVariables.d_error("Errore: la difficoltà deve essere tra 1 e 5.", "MAP_GENERATION")
-		return -1
+		return null
 	
-	var config = _get_difficulty_config(difficulty_level)
-	var map_data = _generate_valid_map_sync(config)
+	return Generation.new(_get_difficulty_config(difficulty_level))
+
+func save_result(generation: Generation, map_name: String) -> int:
+	"""
+	Save the map found by a finished generation.
 	
-	if map_data.error_code != 0:
-		return map_data.error_code
+	Returns:
+		0 on success, -104 if the generation failed or was cancelled
+	"""
+	if generation.status != GenerationStatus.DONE:
+		return -104
 	
-	# Salva la mappa
-	MapIO.save_map_to_file(map_name, map_data.map, difficulty_level, map_data.result, map_data.width, map_data.height)
+	var map_data = generation.map_data
+	MapIO.save_map_to_file(map_name, map_data.map, generation.config.difficulty, map_data.result, map_data.width, map_data.height)
 	
-	_print_generation_success(map_data.attempts, map_data.result.min_moves)
+	_print_generation_success(map_data.attempts, generation.config.min_moves, map_data.result.min_moves)
 	return 0
 
 func test_map(map_name: String):
@@ -79,51 +187,7 @@ func _get_difficulty_config(difficulty_level: int) -> Dictionary:
 		"difficulty": difficulty_level
 	}
 
-func _generate_valid_map(config: Dictionary) -> Dictionary:
-	min_moves = config.min_moves
-	max_moves = config.max_moves
-	
-	var width = config.min_size + (randi() % (config.max_size - config.min_size + 1))
-	var height = config.min_size + (randi() % (config.max_size - config.min_size + 1))
-	
-	var attempts = 0
-	var positions = [0, 0, 0, 0]
-	
-	while attempts < config.max_attempts:
-		attempts += 1
-		
-		# Update UI every 10 attempts for browser responsiveness  
-		if attempts % 10 == 0:
-			# Yield to allow browser to process
-			await Engine.get_main_loop().process_frame
-			
-		if attempts % 100 == 0:
-			GlobalVariables.d_debug("Tentativo " + str(attempts) + "/" + str(config.max_attempts) + "...", "MAP_GENERATION")
-		
-		var map = MapGeneration.generate_single_map(width, height, config.difficulty, positions)
-		
-		var result = MapPathfinding.calculate_min_moves_and_path(map, positions[0], positions[1], positions[2], positions[3], max_moves)
-		
-		if result.min_moves == -1:
-			continue
-			
-		if _is_valid_move_count(result.min_moves):
-			return {
-				"map": map,
-				"result": result,
-				"width": width,
-				"height": height,
-				"attempts": attempts,
-				"error_code": 0
-			}
-	
-	GlobalVariables.d_error("Errore: impossibile generare una mappa valida dopo " + str(config.max_attempts) + " tentativi.", "MAP_GENERATION")
-	return {"error_code": -104}
-
-func _is_valid_move_count(moves: int) -> bool:
-	return moves >= min_moves and moves <= max_moves
-
-func _print_generation_success(attempts: int, moves_found: int):
+func _print_generation_success(attempts: int, min_moves: int, moves_found: int):
 	GlobalVariables.d_info("Mappa valida trovata dopo " + str(attempts) + " tentativi.", "MAP_GENERATION")
 	GlobalVariables.d_info("Numero minimo di mosse richieste: " + str(min_moves) + " (trovate " + str(moves_found) + ")", "MAP_GENERATION")
 
@@ -132,40 +196,3 @@ func _print_move_sequence(result: MapPathfinding.PathResult):
 	
 	for i in range(result.full_path.size()):
 		GlobalVariables.d_debug(str(i + 1) + ". " + MapConstants.direction_to_string(result.full_path[i]), "MAP_GENERATION")
-
-func _generate_valid_map_sync(config: Dictionary) -> Dictionary:
-	"""Synchronous version of _generate_valid_map for use in threads"""
-	min_moves = config.min_moves
-	max_moves = config.max_moves
-	
-	var width = config.min_size + (randi() % (config.max_size - config.min_size + 1))
-	var height = config.min_size + (randi() % (config.max_size - config.min_size + 1))
-	
-	var attempts = 0
-	var positions = [0, 0, 0, 0]
-	
-	while attempts < config.max_attempts:
-		attempts += 1
-		
-		if attempts % 100 == 0:
-			GlobalVariables.d_debug("Tentativo " + str(attempts) + "/" + str(config.max_attempts) + "...", "MAP_GENERATION")
-		
-		var map = MapGeneration.generate_single_map(width, height, config.difficulty, positions)
-		
-		var result = MapPathfinding.calculate_min_moves_and_path(map, positions[0], positions[1], positions[2], positions[3], max_moves)
-		
-		if result.min_moves == -1:
-			continue
-			
-		if _is_valid_move_count(result.min_moves):
-			return {
-				"map": map,
-				"result": result,
-				"width": width,
-				"height": height,
-				"attempts": attempts,
-				"error_code": 0
-			}
-	
-	GlobalVariables.d_error("Errore: impossibile generare una mappa valida dopo " + str(config.max_attempts) + " tentativi.", "MAP_GENERATION")
-	return {"error_code": -104}
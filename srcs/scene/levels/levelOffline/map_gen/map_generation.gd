@@ -1,16 +1,23 @@
 class_name MapGeneration
 
+# Passi di costruzione di generate_single_map (ingresso/uscita + sei tipi di terreno),
+# eseguibili uno alla volta dalla generazione a fette
+const BUILD_STEPS = 7
+
 static func create_empty_map(width: int, height: int) -> Array:
 	var map = []
 	for y in range(height):
-		var row = []
-		for x in range(width):
-			if x == 0 or x == width - 1 or y == 0 or y == height - 1:
-				row.append('M')
-			else:
-				row.append('G')
-		map.append(row)
+		map.append(create_empty_row(width, height, y))
 	return map
+
+static func create_empty_row(width: int, height: int, y: int) -> Array:
+	var row = []
+	for x in range(width):
+		if x == 0 or x == width - 1 or y == 0 or y == height - 1:
+			row.append('M')
+		else:
+			row.append('G')
+	return row
 static func place_start_and_end(map: Array, start_pos: Array, end_pos: Array):
 	var width = map[0].size()
 	var height = map.size()
@@ -160,20 +167,31 @@ static func add_conveyor_belts(map: Array, difficulty: int, start_x: int, start_
 
 static func generate_single_map(width: int, height: int, difficulty: int, positions: Array) -> Array:
 	var map = create_empty_map(width, height)
-	var start_pos = [0, 0]
-	var end_pos = [0, 0]
-		
-	place_start_and_end(map, start_pos, end_pos)
-	positions[0] = start_pos[0]  # start_x
-	positions[1] = start_pos[1]  # start_y
-	positions[2] = end_pos[0]	# end_x
-	positions[3] = end_pos[1]	# end_y
-		
-	add_normal_terrain(map, difficulty, start_pos[0], start_pos[1], end_pos[0], end_pos[1])
-	add_obstacles(map, difficulty, start_pos[0], start_pos[1], end_pos[0], end_pos[1])
-	add_scattered_walls(map)
-	add_fragile_ice(map, difficulty, start_pos[0], start_pos[1], end_pos[0], end_pos[1])
-	add_conveyor_belts(map, difficulty, start_pos[0], start_pos[1], end_pos[0], end_pos[1])
-	add_deadly_holes(map, difficulty, start_pos[0], start_pos[1], end_pos[0], end_pos[1])
+	
+	for build_step in range(BUILD_STEPS):
+		run_build_step(map, difficulty, positions, build_step)
 		
 	return map
+
+static func run_build_step(map: Array, difficulty: int, positions: Array, build_step: int):
+	match build_step:
+		0:
+			var start_pos = [0, 0]
+			var end_pos = [0, 0]
+			place_start_and_end(map, start_pos, end_pos)
+			positions[0] = start_pos[0]  # start_x
+			positions[1] = start_pos[1]  # start_y
+			positions[2] = end_pos[0]	# end_x
+			positions[3] = end_pos[1]	# end_y
+		1:
+			add_normal_terrain(map, difficulty, positions[0], positions[1], positions[2], positions[3])
+		2:
+			add_obstacles(map, difficulty, positions[0], positions[1], positions[2], positions[3])
+		3:
+			add_scattered_walls(map)
+		4:
+			add_fragile_ice(map, difficulty, positions[0], positions[1], positions[2], positions[3])
+		5:
+			add_conveyor_belts(map, difficulty, positions[0], positions[1], positions[2], positions[3])
+		6:
+			add_deadly_holes(map, difficulty, positions[0], positions[1], positions[2], positions[3])
@@ -28,51 +28,105 @@ static func create_3d_array(width: int, height: int, depth: int, default_value =
 		array.append(row)
 	return array
 
-static func run_dijkstra_search(map: Array, start_x: int, start_y: int, end_x: int, end_y: int, max_moves: int) -> DijkstraResult:
-	var width = map[0].size()
-	var height = map.size()
-		
-	var distance = create_3d_array(width, height, 5, -1)
-	var parent = create_3d_array(width, height, 5, [-1, -1, -1])
-		
-	var broken_ice = {}
-
-	var queue = [[start_x, start_y, MapConstants.DIRECTIONS.INITIAL, broken_ice]]
-	distance[start_y][start_x][MapConstants.DIRECTIONS.INITIAL] = 0
+# Ricerca di Dijkstra riprendibile: advance() espande al massimo max_units stati per chiamata,
+# così la generazione senza thread (build web) può dividere una ricerca su più frame
+class DijkstraSearch:
+	var map: Array
+	var start_x: int
+	var start_y: int
+	var end_x: int
+	var end_y: int
+	var max_moves: int
+	var height: int
+	var distance_row: Array
+	var parent_row: Array
+	var distance: Array = []
+	var parent: Array = []
+	var queue: Array
+	var head: int = 0
+	var found: bool = false
+	var done: bool = false
+	
+	func _init(search_map: Array, search_start_x: int, search_start_y: int, search_end_x: int, search_end_y: int, search_max_moves: int):
+		map = search_map
+		start_x = search_start_x
+		start_y = search_start_y
+		end_x = search_end_x
+		end_y = search_end_y
+		max_moves = search_max_moves
 		
-	while not queue.is_empty():
-		var current = queue.pop_front()
-		var x = current[0]
-		var y = current[1] 
-		var last_dir = current[2]
+		# Righe modello: distance e parent vengono copiati una riga per unità di lavoro in advance()
+		var width = map[0].size()
+		height = map.size()
+		distance_row = MapPathfinding.create_3d_array(width, 1, 5, -1)[0]
+		parent_row = MapPathfinding.create_3d_array(width, 1, 5, [-1, -1, -1])[0]
 		
-		if x == end_x and y == end_y :
-			#print("trovato percorso : ", distance[y][x][last_dir])
-			return DijkstraResult.new(distance, parent)
-
-		if distance[y][x][last_dir] > max_moves:
-			#print("interrotto percorso troppo lungo")
-			return null
-
-		for i in range(4):
-			var dir_vec = MapConstants.DIRECTION_VECTORS[i]
-			var result = MapTerrain.simulate_move(map, current[3], x, y, dir_vec[0], dir_vec[1])
+		var broken_ice = {}
+		queue = [[start_x, start_y, MapConstants.DIRECTIONS.INITIAL, broken_ice]]
+	
+	# Restituisce true quando la ricerca è terminata (con o senza percorso)
+	func advance(max_units: int) -> bool:
+		var units = 0
+		while not done and units < max_units:
+			units += 1
 			
-			var pos = result[0]  # result[0] è la nuova posizione dopo il movimento
-			var new_ice_broken = result[1]  
-
-			if (pos.x == x and pos.y == y) or MapTerrain.is_deadly_terrain(map, pos.x, pos.y) or new_ice_broken.has(pos):
+			# Anche l'allocazione è a fette: fino a 55x55x5 celle costerebbero troppo in un solo frame
+			if distance.size() < height:
+				distance.append(distance_row.duplicate(true))
+				parent.append(parent_row.duplicate(true))
+				if distance.size() == height:
+					distance[start_y][start_x][MapConstants.DIRECTIONS.INITIAL] = 0
 				continue
 			
-			var move_cost = 1 if (last_dir == MapConstants.DIRECTIONS.INITIAL or last_dir != i) else 0
-			var new_distance = distance[y][x][last_dir] + move_cost
+			# La coda avanza per indice invece di pop_front(): stesso ordine, senza spostare l'array
+			if head >= queue.size():
+				done = true
+				break
+			var current = queue[head]
+			head += 1
+			var x = current[0]
+			var y = current[1] 
+			var last_dir = current[2]
+			
+			if x == end_x and y == end_y :
+				found = true
+				done = true
+				break
 			
-			if distance[pos.y][pos.x][i] == -1 or distance[pos.y][pos.x][i] > new_distance:
-				distance[pos.y][pos.x][i] = new_distance
-				parent[pos.y][pos.x][i] = [x, y, last_dir]
-				queue.append([pos.x, pos.y, i, result[1]])  # result[1] è l'asse del ghiaccio rotto
-	#print("nessun percorso trovato")
-	return null
+			if distance[y][x][last_dir] > max_moves:
+				done = true
+				break
+			
+			for i in range(4):
+				var dir_vec = MapConstants.DIRECTION_VECTORS[i]
+				var result = MapTerrain.simulate_move(map, current[3], x, y, dir_vec[0], dir_vec[1])
+				
+				var pos = result[0]  # result[0] è la nuova posizione dopo il movimento
+				var new_ice_broken = result[1]  
+				
+				if (pos.x == x and pos.y == y) or MapTerrain.is_deadly_terrain(map, pos.x, pos.y) or new_ice_broken.has(pos):
+					continue
+				
+				var move_cost = 1 if (last_dir == MapConstants.DIRECTIONS.INITIAL or last_dir != i) else 0
+				var new_distance = distance[y][x][last_dir] + move_cost
+				
+				if distance[pos.y][pos.x][i] == -1 or distance[pos.y][pos.x][i] > new_distance:
+					distance[pos.y][pos.x][i] = new_distance
+					parent[pos.y][pos.x][i] = [x, y, last_dir]
+					queue.append([pos.x, pos.y, i, result[1]])  # result[1] è l'asse del ghiaccio rotto
+		return done
+	
+	# null se l'uscita non è raggiungibile entro max_moves
+	func get_result() -> MapPathfinding.DijkstraResult:
+		if not found:
+			return null
+		return MapPathfinding.DijkstraResult.new(distance, parent)
+
+static func run_dijkstra_search(map: Array, start_x: int, start_y: int, end_x: int, end_y: int, max_moves: int) -> DijkstraResult:
+	var search = DijkstraSearch.new(map, start_x, start_y, end_x, end_y, max_moves)
+	while not search.advance(1000000):
+		pass
+	return search.get_result()
 
 static func find_best_final_direction(distance: Array, end_x: int, end_y: int) -> int:
 	var best_dir = -1
@@ -110,6 +164,9 @@ static func reconstruct_full_move_path(parent: Array, _map: Array, start_x: int,
 
 static func calculate_min_moves_and_path(map: Array, start_x: int, start_y: int, end_x: int, end_y: int, max_moves: int) -> PathResult:
 	var search_result = run_dijkstra_search(map, start_x, start_y, end_x, end_y, max_moves)
+	return build_path_result(search_result, map, start_x, start_y, end_x, end_y)
+
+static func build_path_result(search_result: DijkstraResult, map: Array, start_x: int, start_y: int, end_x: int, end_y: int) -> PathResult:
 	if search_result == null:
 		return PathResult.new(-1, [])
 	var distance = search_result.distance